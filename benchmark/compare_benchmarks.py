@@ -0,0 +1,52 @@
+import argparse
+import json
+import sys
+
+# Compare the JSON written by int_tri_bench against a stored baseline, and fail if any phase got slower
+
+parser = argparse.ArgumentParser()
+parser.add_argument("baseline", help="JSON results to compare against, e.g. from the last release")
+parser.add_argument("current", help="JSON results to check")
+parser.add_argument("--metric", choices=["min", "median", "mean"], default="median",
+                    help="statistic of the timed repetitions to compare (default=median)")
+parser.add_argument("--threshold", type=float, default=0.1,
+                    help="relative slowdown reported as a regression (default=0.1, i.e. 10%%)")
+parser.add_argument("--min_time", type=float, default=1e-3,
+                    help="ignore phases faster than this many seconds in both runs, which are mostly noise (default=1e-3)")
+args = parser.parse_args()
+
+def load_benchmarks(path):
+    with open(path) as f:
+        results = json.load(f)
+    return results["context"], {b["name"]: b for b in results["benchmarks"]}
+
+baseline_context, baseline = load_benchmarks(args.baseline)
+current_context, current = load_benchmarks(args.current)
+
+for key in ["threads", "format"]:
+    if baseline_context.get(key) != current_context.get(key):
+        print(f"Warning: runs differ in {key} ({baseline_context.get(key)} in the baseline, {current_context.get(key)} now)")
+
+regressions = []
+print(f"{'benchmark':<70} {'baseline':>10} {'current':>10} {'change':>8}")
+for name, bench in current.items():
+    if name not in baseline:
+        print(f"{name:<70} {'-':>10} {bench[args.metric]:>10.4f}      new")
+        continue
+    old = baseline[name][args.metric]
+    new = bench[args.metric]
+    change = (new - old) / old if old > 0 else 0.
+    flag = ""
+    if change > args.threshold and max(old, new) >= args.min_time:
+        regressions.append(name)
+        flag = "  <- regression"
+    print(f"{name:<70} {old:>10.4f} {new:>10.4f} {100 * change:>7.1f}%{flag}")
+
+for name in baseline:
+    if name not in current:
+        print(f"{name:<70} {baseline[name][args.metric]:>10.4f} {'-':>10}  missing")
+
+if regressions:
+    print(f"\n{len(regressions)} of {len(current)} benchmarks regressed by more than {100 * args.threshold:.0f}%")
+    sys.exit(1)
+print(f"\nNo regressions of more than {100 * args.threshold:.0f}%")
@@ -0,0 +1,349 @@
+// Times the phases int_tri runs, one at a time, on a fixed set of meshes for each intrinsic triangulation backend:
+// flipping, refinement, tracing the common subdivision, meshing it, and assembling and encoding each output. Outputs
+// are encoded in memory but never written, so that timings do not include disk I/O or process startup.
+//
+// Each phase is run a number of warmup times and then timed a number of repetitions, starting from a fresh copy of
+// the state it needs (which is untimed). Results are written as JSON, to be compared against a stored baseline with
+// compare_benchmarks.py.
+
+#include "geometrycentral/surface/common_subdivision.h"
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/meshio.h"
+#include "geometrycentral/surface/transfer_functions.h"
+
+#include "args/args.hxx"
+#include "intrinsic_outputs.h"
+#include "laplacian_assembly.h"
+#include "matrix_io.h"
+#include "mesh_loading.h"
+#include "triangulation_pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+namespace {
+
+struct BenchmarkSettings {
+  size_t warmup = 1;
+  size_t repetitions = 5;
+  size_t nThreads = 1;
+  std::string formatName = "binary";
+  MatrixFormat format = MatrixFormat::Binary;
+  double refineAngle = 25.;
+  int refineMaxInsertions = -10;
+};
+
+// One phase to time. setup() runs untimed before every run(), and should build the state run() consumes. run()
+// returns the number of bytes it encoded, if any, which also keeps the compiler from discarding the work.
+struct BenchmarkCase {
+  std::string phase;
+  std::function<void()> setup;
+  std::function<size_t()> run;
+};
+
+struct BenchmarkResult {
+  std::string mesh;
+  std::string backend;
+  std::string phase;
+  std::vector<double> seconds;
+  size_t bytes = 0;
+};
+
+// A mesh and one backend's triangulation of it, prepared as int_tri does before each phase
+class BenchmarkMesh {
+public:
+  BenchmarkMesh(ManifoldSurfaceMesh& mesh_, VertexPositionGeometry& geometry_, std::string backend_,
+                const BenchmarkSettings& settings_)
+      : mesh(mesh_), geometry(geometry_), backend(backend_), settings(settings_) {}
+
+  IntrinsicTriangulation& fresh() {
+    intTri = makeIntrinsicTriangulation(backend, mesh, geometry);
+    return *intTri;
+  }
+
+  IntrinsicTriangulation& flipped() {
+    fresh().flipToDelaunay();
+    return *intTri;
+  }
+
+  void refine() {
+    size_t maxInsertions = INVALID_IND;
+    if (settings.refineMaxInsertions > 0) maxInsertions = settings.refineMaxInsertions;
+    if (settings.refineMaxInsertions < 0) maxInsertions = -settings.refineMaxInsertions * mesh.nVertices();
+    intTri->delaunayRefine(settings.refineAngle, std::numeric_limits<double>::infinity(), maxInsertions);
+  }
+
+  IntrinsicTriangulation& refined() {
+    flipped();
+    refine();
+    return *intTri;
+  }
+
+  // The state every output is assembled from: a refined triangulation, with its common subdivision traced and meshed
+  void prepareOutputs() {
+    refined();
+    intTri->getCommonSubdivision().constructMesh();
+  }
+
+  IntrinsicTriangulation& triangulation() { return *intTri; }
+
+  ManifoldSurfaceMesh& mesh;
+  VertexPositionGeometry& geometry;
+
+private:
+  std::string backend;
+  const BenchmarkSettings& settings;
+  std::unique_ptr<IntrinsicTriangulation> intTri;
+};
+
+double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+BenchmarkResult runCase(const BenchmarkCase& bench, const BenchmarkSettings& settings) {
+  BenchmarkResult result;
+  result.phase = bench.phase;
+  for (size_t iR = 0; iR < settings.warmup + settings.repetitions; iR++) {
+    bench.setup();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t bytes = bench.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (iR >= settings.warmup) {
+      result.seconds.push_back(seconds);
+      result.bytes = bytes;
+    }
+  }
+  return result;
+}
+
+// The phases of one mesh and backend. The triangulation phases each start from a new triangulation. The outputs are
+// all assembled from the state left by BenchmarkMesh::prepareOutputs(), which they do not modify, and come last.
+std::vector<BenchmarkCase> benchmarkCases(BenchmarkMesh& bm, const BenchmarkSettings& settings) {
+  std::vector<BenchmarkCase> cases;
+  auto nothing = []() {};
+  auto meshed = [&bm]() -> CommonSubdivision& { return bm.triangulation().getCommonSubdivision(); };
+
+  cases.push_back(BenchmarkCase{"flipToDelaunay", [&bm]() { bm.fresh(); },
+                                [&bm]() -> size_t {
+                                  bm.triangulation().flipToDelaunay();
+                                  return 0;
+                                }});
+  cases.push_back(BenchmarkCase{"delaunayRefine", [&bm]() { bm.flipped(); },
+                                [&bm]() -> size_t {
+                                  bm.refine();
+                                  return 0;
+                                }});
+  cases.push_back(BenchmarkCase{"commonSubdivision/trace", [&bm]() { bm.refined(); },
+                                [&bm]() -> size_t {
+                                  bm.triangulation().getCommonSubdivision();
+                                  return 0;
+                                }});
+  cases.push_back(BenchmarkCase{"commonSubdivision/constructMesh",
+                                [&bm]() { bm.refined().getCommonSubdivision(); },
+                                [&bm]() -> size_t {
+                                  bm.triangulation().getCommonSubdivision().constructMesh();
+                                  return 0;
+                                }});
+
+  // Each output is assembled and encoded as int_tri's writer for it does, up to handing the file to be written
+  auto intrinsicOutput = [&bm, &settings](IntrinsicOutputs request) -> IntrinsicOutputBuffers {
+    IntrinsicTriangulation& tri = bm.triangulation();
+    IntrinsicOutputBuffers buffers;
+    assembleIntrinsicOutputs(IntrinsicView{tri.mesh, tri, tri.vertexLocations}, bm.geometry.inputVertexPositions,
+                             request, buffers, settings.nThreads);
+    return buffers;
+  };
+  MatrixFormat format = settings.format;
+  cases.push_back(BenchmarkCase{"output/intrinsicFaces", nothing, [=]() -> size_t {
+                                  IntrinsicOutputs request;
+                                  request.intrinsicFaces = true;
+                                  IntrinsicOutputBuffers buffers = intrinsicOutput(request);
+                                  return encodeDenseMatrix(format, buffers.faceInds).size() +
+                                         encodeDenseMatrix(format, buffers.faceLengths).size();
+                                }});
+  cases.push_back(BenchmarkCase{"output/vertexPositions", nothing, [=]() -> size_t {
+                                  IntrinsicOutputs request;
+                                  request.vertexPositions = true;
+                                  return encodeDenseMatrix(format, intrinsicOutput(request).vertexPositions).size();
+                                }});
+  cases.push_back(BenchmarkCase{"output/interpolateMat", nothing, [=]() -> size_t {
+                                  IntrinsicOutputs request;
+                                  request.interpolateMat = true;
+                                  return encodeSparseMatrix(format, intrinsicOutput(request).interpolate).size();
+                                }});
+  auto laplacianOutput = [&bm, &settings](bool massMatrix) -> size_t {
+    IntrinsicTriangulation& tri = bm.triangulation();
+    LaplacianAssembler assembler(tri.mesh, tri.intrinsicEdgeLengths);
+    assembler.update(settings.nThreads);
+    SparseMatrix<double> matrix(massMatrix ? assembler.lumpedMass() : assembler.laplacian());
+    return encodeSparseMatrix(settings.format, matrix).size();
+  };
+  cases.push_back(BenchmarkCase{"output/laplaceMat", nothing, [=]() { return laplacianOutput(false); }});
+  cases.push_back(BenchmarkCase{"output/massMat", nothing, [=]() { return laplacianOutput(true); }});
+  cases.push_back(BenchmarkCase{"output/functionTransferMat", nothing, [&bm, meshed, format]() -> size_t {
+                                  AttributeTransfer transfer(meshed(), bm.geometry);
+                                  size_t bytes = 0;
+                                  SparseMatrix<double> lhs, rhs;
+                                  std::tie(lhs, rhs) = transfer.constructAtoBMatrices();
+                                  bytes += encodeSparseMatrix(format, lhs).size();
+                                  bytes += encodeSparseMatrix(format, rhs).size();
+                                  std::tie(lhs, rhs) = transfer.constructBtoAMatrices();
+                                  bytes += encodeSparseMatrix(format, lhs).size();
+                                  bytes += encodeSparseMatrix(format, rhs).size();
+                                  return bytes;
+                                }});
+  cases.push_back(BenchmarkCase{"output/commonSubdivision", nothing, [&bm, meshed]() -> size_t {
+                                  CommonSubdivision& cs = meshed();
+                                  VertexPositionGeometry csGeo(*cs.mesh,
+                                                               cs.interpolateAcrossA(bm.geometry.vertexPositions));
+                                  std::ostringstream obj;
+                                  writeSurfaceMesh(*cs.mesh, csGeo, obj, "obj");
+                                  return obj.str().size();
+                                }});
+  return cases;
+}
+
+std::string jsonString(std::string s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results, const BenchmarkSettings& settings) {
+  char date[32];
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  out.precision(9);
+  out << "{\n  \"context\": {\"date\": " << jsonString(date) << ", \"warmup\": " << settings.warmup
+      << ", \"repetitions\": " << settings.repetitions << ", \"threads\": " << settings.nThreads
+      << ", \"format\": " << jsonString(settings.formatName) << "},\n  \"benchmarks\": [";
+  for (size_t iB = 0; iB < results.size(); iB++) {
+    const BenchmarkResult& r = results[iB];
+    double mean = 0, variance = 0;
+    for (double s : r.seconds) mean += s / r.seconds.size();
+    for (double s : r.seconds) variance += (s - mean) * (s - mean) / r.seconds.size();
+
+    out << (iB == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(r.mesh + "/" + r.backend + "/" + r.phase)
+        << ", \"mesh\": " << jsonString(r.mesh) << ", \"backend\": " << jsonString(r.backend)
+        << ", \"phase\": " << jsonString(r.phase) << ", \"bytes\": " << r.bytes
+        << ", \"min\": " << *std::min_element(r.seconds.begin(), r.seconds.end())
+        << ", \"median\": " << median(r.seconds) << ", \"mean\": " << mean << ", \"stddev\": " << std::sqrt(variance)
+        << ", \"seconds\": [";
+    for (size_t iR = 0; iR < r.seconds.size(); iR++) out << (iR == 0 ? "" : ", ") << r.seconds[iR];
+    out << "]}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  // clang-format off
+  args::ArgumentParser parser("Time each phase of int_tri on a set of meshes, and write the timings as JSON");
+  args::HelpFlag help(parser, "help", "Display this help message", {'h', "help"});
+  args::PositionalList<std::string> meshFilenames(parser, "meshes", "The .obj or .ply meshes to run on");
+  args::ValueFlag<std::string> backendFlag(parser, "backend", "Data structure to use (signpost, integer or both). Default: both", {"backend"}, "both");
+  args::Flag triangulateInput(parser, "triangulate", "Fan-triangulate polygonal input meshes", {"triangulate"});
+  args::ValueFlag<size_t> warmup(parser, "warmup", "Untimed runs of each phase before the timed ones. Default: 1", {"warmup"}, 1);
+  args::ValueFlag<size_t> repetitions(parser, "repetitions", "Timed runs of each phase. Default: 5", {"repetitions"}, 5);
+  args::ValueFlag<size_t> threads(parser, "threads", "Threads used to assemble outputs. Use 0 for one per hardware thread. Default: 1", {"threads"}, 1);
+  args::ValueFlag<std::string> outputFormat(parser, "outputFormat", "Format to encode matrices in, binary or ascii. Default: binary", {"outputFormat"}, "binary");
+  args::ValueFlag<std::string> outputFile(parser, "output", "File to write the JSON results to. Default: stdout", {"output"});
+  // clang-format on
+
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (const args::Help& h) {
+    std::cout << parser;
+    return 0;
+  } catch (const args::ParseError& e) {
+    std::cerr << e.what() << std::endl;
+    std::cerr << parser;
+    return 1;
+  }
+  if (!meshFilenames || args::get(repetitions) == 0) {
+    std::cerr << parser;
+    return EXIT_FAILURE;
+  }
+
+  BenchmarkSettings settings;
+  settings.warmup = args::get(warmup);
+  settings.repetitions = args::get(repetitions);
+  settings.nThreads = args::get(threads);
+  std::vector<std::string> backends;
+  try {
+    settings.formatName = args::get(outputFormat);
+    settings.format = matrixFormatFromString(settings.formatName);
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string backend = args::get(backendFlag);
+  if (backend == "integer" || backend == "both") backends.push_back("Integer Coordinates");
+  if (backend == "signpost" || backend == "both") backends.push_back("Signposts");
+  if (backends.empty()) {
+    std::cerr << "Error: unrecognized backend '" << backend << "', should be 'signpost', 'integer' or 'both'"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<BenchmarkResult> results;
+  for (const std::string& filename : args::get(meshFilenames)) {
+    std::unique_ptr<ManifoldSurfaceMesh> mesh;
+    std::unique_ptr<VertexPositionGeometry> geometry;
+    try {
+      std::tie(mesh, geometry) = loadManifoldMesh(filename, args::get(triangulateInput), "", settings.nThreads);
+    } catch (const std::exception& e) {
+      std::cerr << "Error: failed to load " << filename << ": " << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for (const std::string& backendName : backends) {
+      BenchmarkMesh bm(*mesh, *geometry, backendName, settings);
+      bool outputsPrepared = false;
+      for (const BenchmarkCase& bench : benchmarkCases(bm, settings)) {
+        if (!outputsPrepared && bench.phase.compare(0, 7, "output/") == 0) {
+          bm.prepareOutputs();
+          outputsPrepared = true;
+        }
+        results.push_back(runCase(bench, settings));
+        results.back().mesh = meshNameFromPath(filename);
+        results.back().backend = backendName;
+        std::cerr << results.back().mesh << "/" << backendName << "/" << bench.phase << ": "
+                  << median(results.back().seconds) << "s" << std::endl;
+      }
+    }
+  }
+
+  if (outputFile) {
+    std::ofstream out(args::get(outputFile));
+    if (!out.is_open()) {
+      std::cerr << "Error: failed to open " << args::get(outputFile) << std::endl;
+      return EXIT_FAILURE;
+    }
+    writeJson(out, results, settings);
+  } else {
+    writeJson(std::cout, results, settings);
+  }
+  return EXIT_SUCCESS;
+}
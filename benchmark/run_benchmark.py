@@ -52,6 +52,14 @@ class ShellTaskQueue(Queue):
 # location of flip binaries, assumed relative to this file
 BIN_DIR = os.path.abspath(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "build", "bin"))
 
+# runs never open the GUI, so use the headless build, which starts faster, and fall back to the GUI build
+INT_TRI_BIN = os.path.join(BIN_DIR, "int_tri_cli")
+if not os.path.exists(INT_TRI_BIN):
+    INT_TRI_BIN = os.path.join(BIN_DIR, "int_tri")
+
+# input formats int_tri reads
+MESH_EXTENSIONS = [".obj", ".stl", ".ply", ".off"]
+
 def ensure_dir_exists(d):
     if not os.path.exists(d):
         os.makedirs(d)
@@ -82,6 +90,9 @@ def main():
 
     parser.add_argument('--operation', type=str, default="flipDelaunay", help='Operation to test ("flipDelaunay" or "refineDelaunay")')
     parser.add_argument('--max_meshes', type=int, default=-1)
+    parser.add_argument('--batch_size', type=int, default=1, help='number of meshes to process in each int_tri process (the timeout is scaled accordingly)')
+    parser.add_argument('--time_budget', type=str, help='wall-clock budget for each mesh\'s flips or refinement, e.g. 60s, after which it stops and writes what it has (optional)')
+    parser.add_argument('--batch_threads', type=int, default=1, help='number of meshes each batch process works on concurrently')
 
     # Parse arguments
     args = parser.parse_args()
@@ -103,13 +114,16 @@ def main():
     if args.bad_list:
         bad_set = parse_file_list(args.bad_list)
 
-    # Load the list of meshes
+    # Load the list of meshes. Both the single-mesh and the batch runs below take only these, so every file is filtered
+    # here, before any manifests are written.
     meshes = []
-    for f in os.listdir(args.dataset_dir):
+    for f in sorted(os.listdir(args.dataset_dir)):
 
         # respect lists
         f_name , f_ext = os.path.splitext(os.path.basename(f))
-        if f_ext not in [".obj", ".stl", ".ply", ".off"]:
+        if f_ext.lower() not in MESH_EXTENSIONS:
+            continue
+        if not os.path.isfile(os.path.join(args.dataset_dir, f)):
             continue
 
         if args.good_list and f_name not in good_set:
@@ -123,33 +137,52 @@ def main():
 
     print("Found {} input mesh files".format(len(meshes)))
     # random.shuffle(meshes)
-    task_queue = ShellTaskQueue(nWorkers=args.n_threads, timeout=args.timeout)
-
-    for m_path in meshes:
-        m_basename = os.path.basename(m_path)
-        m_base, m_ext = os.path.splitext(m_basename)
-
-        if m_ext not in [".obj", ".stl", ".ply", ".off"]:
-            continue
-
-        output_prefix = os.path.join(abs_output_dir, m_base)
-        operation_flag = "--flipDelaunay" if args.operation == "flipDelaunay" else "--refineDelaunay"
-
-        cmd_list = [
-            os.path.join(BIN_DIR,"int_tri"),
-            m_path,
-            operation_flag,
-            f"--outputPrefix={output_prefix}_",
-            "--logStats",
-            "--triangulateInput",
-            "--noGUI",
-            "--refineMaxInsertions=0",
-        ]
-
-        # build the command
-        cmd_str = " ".join(cmd_list)
-
-        task_queue.add_task(cmd_str)
+    task_queue = ShellTaskQueue(nWorkers=args.n_threads, timeout=args.timeout * max(args.batch_size, 1))
+
+    operation_flag = "--flipDelaunay" if args.operation == "flipDelaunay" else "--refineDelaunay"
+    common_flags = [
+        operation_flag,
+        "--logStats",
+        "--triangulateInput",
+        "--noGUI",
+        "--refineMaxInsertions=0",
+    ]
+    if args.time_budget:
+        budget_flag = "--flipTimeBudget" if args.operation == "flipDelaunay" else "--refineTimeBudget"
+        common_flags.append(f"{budget_flag}={args.time_budget}")
+
+    if args.batch_size > 1:
+        # write manifests listing the meshes for each int_tri process
+        manifest_dir = os.path.join(abs_output_dir, "manifests")
+        ensure_dir_exists(manifest_dir)
+
+        for i_batch, i_start in enumerate(range(0, len(meshes), args.batch_size)):
+            manifest_path = os.path.join(manifest_dir, f"batch_{i_batch}.txt")
+            with open(manifest_path, 'w') as f:
+                for m_path in meshes[i_start:i_start+args.batch_size]:
+                    m_base, _ = os.path.splitext(os.path.basename(m_path))
+                    output_prefix = os.path.join(abs_output_dir, m_base)
+                    f.write(f"{m_path}\t{output_prefix}_\n")
+
+            cmd_list = [INT_TRI_BIN, f"--batch={manifest_path}", f"--threads={args.batch_threads}"] + common_flags
+            task_queue.add_task(" ".join(cmd_list))
+    else:
+        for m_path in meshes:
+            m_basename = os.path.basename(m_path)
+            m_base, _ = os.path.splitext(m_basename)
+
+            output_prefix = os.path.join(abs_output_dir, m_base)
+
+            cmd_list = [
+                INT_TRI_BIN,
+                m_path,
+                f"--outputPrefix={output_prefix}_",
+            ] + common_flags
+
+            # build the command
+            cmd_str = " ".join(cmd_list)
+
+            task_queue.add_task(cmd_str)
 
     task_queue.join()
 
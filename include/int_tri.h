@@ -0,0 +1,117 @@
+#ifndef INT_TRI_H
+#define INT_TRI_H
+
+/*
+ * C interface to libint_tri: load a mesh, build an intrinsic triangulation of it, flip and refine it, and read its
+ * outputs, all in process.
+ *
+ * Every function taking a pipeline returns INT_TRI_OK on success, or INT_TRI_ERROR with a description available from
+ * int_tri_last_error(). Pipelines are independent, so several may be used at once from different threads, but each
+ * must only be used from one thread at a time.
+ *
+ * Outputs are either copied into buffers owned by the caller (int_tri_get_*), or viewed in place (int_tri_view_*).
+ * Views stay valid until the next call on the same pipeline which is not a query.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(INT_TRI_SHARED_LIBRARY)
+#ifdef INT_TRI_BUILDING_LIBRARY
+#define INT_TRI_API __declspec(dllexport)
+#else
+#define INT_TRI_API __declspec(dllimport)
+#endif
+#else
+#define INT_TRI_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INT_TRI_OK 0
+#define INT_TRI_ERROR 1
+
+typedef struct int_tri_pipeline int_tri_pipeline;
+
+/* A sparse matrix in compressed sparse row form, with 0-indexed rows and columns */
+typedef struct {
+  size_t rows;
+  size_t cols;
+  size_t nnz;
+  const int* rowStart; /* rows + 1 offsets into columns and values */
+  const int* columns;  /* nnz column indices, increasing within each row */
+  const double* values;
+} int_tri_csr_matrix;
+
+/* Create a pipeline, returning NULL if it cannot be allocated, and destroy one (NULL is ignored) */
+INT_TRI_API int_tri_pipeline* int_tri_create(void);
+INT_TRI_API void int_tri_destroy(int_tri_pipeline* pipeline);
+
+/* The reason the last failing call on this pipeline failed, or "" if none has */
+INT_TRI_API const char* int_tri_last_error(const int_tri_pipeline* pipeline);
+
+/* Threads used by parallel loops within each stage, or 0 for one per hardware thread (the default) */
+INT_TRI_API int int_tri_set_threads(int_tri_pipeline* pipeline, size_t nThreads);
+
+/* Set the input mesh, dropping any triangulation of the previous one: either by loading a file (as the int_tri
+ * executable does, optionally splitting polygons into triangles), or from arrays of 3 coordinates per vertex and 3
+ * vertex indices per triangle, which are copied */
+INT_TRI_API int int_tri_load_mesh(int_tri_pipeline* pipeline, const char* filename, int triangulate);
+INT_TRI_API int int_tri_set_mesh(int_tri_pipeline* pipeline, const double* vertexPositions, size_t nVertices,
+                                 const uint64_t* triangles, size_t nTriangles);
+
+/* Start over from the input mesh with a new intrinsic triangulation, using the "integer" (the default) or "signpost"
+ * backend */
+INT_TRI_API int int_tri_reset_triangulation(int_tri_pipeline* pipeline, const char* backend);
+
+/* Flip to Delaunay, and refine, as --flipDelaunay and --refineDelaunay do. maxInsertions is interpreted as
+ * --refineMaxInsertions is: 0 for no limit, or negative to scale by the number of input vertices. */
+INT_TRI_API int int_tri_flip_to_delaunay(int_tri_pipeline* pipeline);
+INT_TRI_API int int_tri_refine_delaunay(int_tri_pipeline* pipeline, double angleDegrees, double circumradius,
+                                        int64_t maxInsertions);
+
+/* Limits on flips and refinement, in seconds from the start of each, as --flipTimeBudget and --refineTimeBudget set;
+ * a negative budget (the default) is no limit. With a limit, that stage works in rounds, and stops at the end of the
+ * first round past it, carrying on from the triangulation so far. */
+INT_TRI_API int int_tri_set_time_budgets(int_tri_pipeline* pipeline, double flipSeconds, double refineSeconds);
+
+/* Stop the flips or refinement running on this pipeline, or else the next to run, at the end of its current round, as
+ * a SIGINT stops the executable's. Only stages with a time budget run in rounds, so only they can stop early. Unlike
+ * every other call, this one may be made from any thread while another runs. */
+INT_TRI_API int int_tri_cancel(int_tri_pipeline* pipeline);
+
+/* How the last flips and refinement ended: "complete", "timeBudget" or "interrupted" (by int_tri_cancel()), or "" if
+ * they have not run on the current triangulation */
+INT_TRI_API const char* int_tri_flip_status(const int_tri_pipeline* pipeline);
+INT_TRI_API const char* int_tri_refine_status(const int_tri_pipeline* pipeline);
+
+/* Sizes of the input mesh and the intrinsic triangulation, or 0 if there is none. There is no intrinsic
+ * triangulation until int_tri_reset_triangulation(), or a call which flips, refines or views a matrix. */
+INT_TRI_API size_t int_tri_num_input_vertices(const int_tri_pipeline* pipeline);
+INT_TRI_API size_t int_tri_num_vertices(const int_tri_pipeline* pipeline);
+INT_TRI_API size_t int_tri_num_faces(const int_tri_pipeline* pipeline);
+
+/* Copy the intrinsic faces as 3 vertex indices per face, and optionally (if faceLengths is not NULL) the length of
+ * the edge following each of those corners, as faceInds.dmat and faceLengths.dmat hold them. nFaces is the number of
+ * faces the buffers have room for, which must be int_tri_num_faces(); these fail, writing nothing, if it is not, or
+ * if there is no intrinsic triangulation yet. */
+INT_TRI_API int int_tri_get_faces(int_tri_pipeline* pipeline, uint64_t* faceVertices, double* faceLengths,
+                                  size_t nFaces);
+
+/* Copy the position of each intrinsic vertex on the input surface, 3 coordinates per vertex. nVertices is the number
+ * of vertices the buffer has room for, which must be int_tri_num_vertices(), as for int_tri_get_faces(). */
+INT_TRI_API int int_tri_get_vertex_positions(int_tri_pipeline* pipeline, double* vertexPositions, size_t nVertices);
+
+/* View the cotan Laplacian, lumped mass matrix and interpolation matrix (laplace.spmat, mass.spmat and
+ * interpolate.spmat) in place */
+INT_TRI_API int int_tri_view_laplacian(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix);
+INT_TRI_API int int_tri_view_mass_matrix(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix);
+INT_TRI_API int int_tri_view_interpolation_matrix(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+#include "async_writer.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h> // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
+AsyncFileWriter::AsyncFileWriter(size_t maxQueuedBytes_) : maxQueuedBytes(maxQueuedBytes_) {
+  ioThread = std::thread(&AsyncFileWriter::ioLoop, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  try {
+    finish();
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+  }
+}
+
+void AsyncFileWriter::write(std::string path, std::string contents) {
+  std::unique_lock<std::mutex> lock(mutex);
+  if (finishing) {
+    throw std::runtime_error("cannot write " + path + " after the writer has finished");
+  }
+  queueChanged.wait(lock, [&]() { return error || queue.empty() || queuedBytes + contents.size() <= maxQueuedBytes; });
+  if (error) std::rethrow_exception(error);
+
+  queuedBytes += contents.size();
+  queue.push_back(QueuedFile{path, std::move(contents)});
+  queueChanged.notify_all();
+}
+
+void AsyncFileWriter::finish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finishing = true;
+    queueChanged.notify_all();
+  }
+  if (ioThread.joinable()) ioThread.join();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (error) {
+    std::exception_ptr e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+void AsyncFileWriter::ioLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    queueChanged.wait(lock, [&]() { return finishing || !queue.empty(); });
+    if (queue.empty()) return; // finishing, and nothing left to write
+
+    QueuedFile file = std::move(queue.front());
+    queue.pop_front();
+
+    // Keep the file's bytes counted against the bound until they are on disk
+    lock.unlock();
+    std::exception_ptr writeError;
+    try {
+      writeFile(file.path, file.contents);
+    } catch (...) {
+      writeError = std::current_exception();
+    }
+    lock.lock();
+
+    queuedBytes -= file.contents.size();
+    if (writeError && !error) error = writeError;
+    queueChanged.notify_all();
+  }
+}
+
+void AsyncFileWriter::writeFile(std::string path, const std::string& contents) {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    throw std::runtime_error("failed to open output file " + path);
+  }
+  bool ok = std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+  ok = ok && std::fflush(file) == 0;
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  ok = std::fclose(file) == 0 && ok;
+  if (!ok) {
+    throw std::runtime_error("failed to write output file " + path);
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes whole files on a dedicated I/O thread, so that encoding the next output can overlap with writing the previous
+// one. Queued file contents are bounded by maxQueuedBytes: write() blocks while the queue is full (a single file larger
+// than the bound is accepted once the queue has drained).
+class AsyncFileWriter {
+public:
+  AsyncFileWriter(size_t maxQueuedBytes = 256 * 1024 * 1024);
+
+  // Waits for queued files to be written, reporting any error rather than throwing
+  ~AsyncFileWriter();
+
+  // Queue a file to be written, taking ownership of its contents. Rethrows the error from an earlier write, if any.
+  void write(std::string path, std::string contents);
+
+  // Block until every queued file has been written, flushed and synced to disk, then stop the I/O thread. Rethrows
+  // the first write error.
+  void finish();
+
+  // Write a file, flush it and sync it to disk on the calling thread. Throws on failure.
+  static void writeFile(std::string path, const std::string& contents);
+
+private:
+  AsyncFileWriter(const AsyncFileWriter&) = delete;
+  AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+  struct QueuedFile {
+    std::string path;
+    std::string contents;
+  };
+
+  void ioLoop();
+
+  const size_t maxQueuedBytes;
+  std::mutex mutex;
+  std::condition_variable queueChanged;
+  std::deque<QueuedFile> queue;
+  size_t queuedBytes = 0;
+  bool finishing = false;
+  std::exception_ptr error;
+  std::thread ioThread;
+};
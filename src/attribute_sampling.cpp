@@ -0,0 +1,34 @@
+#include "attribute_sampling.h"
+
+#include "parallel.h"
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+AttributeMatrix sampleAttributes(const std::vector<SurfacePoint>& points, const AttributeMatrix& inputAttributes,
+                                 size_t nThreads) {
+  AttributeMatrix sampled(points.size(), inputAttributes.cols());
+  parallelFor(
+      points.size(),
+      [&](size_t iP) {
+        const SurfacePoint& p = points[iP];
+        switch (p.type) {
+        case SurfacePointType::Vertex:
+          sampled.row(iP) = inputAttributes.row(p.vertex.getIndex());
+          break;
+        case SurfacePointType::Edge:
+          sampled.row(iP) = (1. - p.tEdge) * inputAttributes.row(p.edge.firstVertex().getIndex()) +
+                            p.tEdge * inputAttributes.row(p.edge.secondVertex().getIndex());
+          break;
+        case SurfacePointType::Face: {
+          Halfedge he = p.face.halfedge();
+          sampled.row(iP) = p.faceCoords.x * inputAttributes.row(he.vertex().getIndex()) +
+                            p.faceCoords.y * inputAttributes.row(he.next().vertex().getIndex()) +
+                            p.faceCoords.z * inputAttributes.row(he.next().next().vertex().getIndex());
+          break;
+        }
+        }
+      },
+      nThreads, 1024);
+  return sampled;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "geometrycentral/surface/surface_point.h"
+
+#include <Eigen/Dense>
+
+#include <cstddef>
+#include <vector>
+
+// Per-vertex attributes with any number of channels: one row per vertex, holding every channel of that vertex
+// contiguously, so that one vertex's channels are combined together
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> AttributeMatrix;
+
+// Sample every channel of inputAttributes (one row per input vertex, in index order) at each point on the input mesh,
+// as SurfacePoint::interpolate() does for a single field. Each point's location is looked up once for all channels,
+// and its row is a weighted sum of at most three input rows, which the compiler vectorizes across channels. Points are
+// processed on nThreads threads (0 means one per hardware thread).
+AttributeMatrix sampleAttributes(const std::vector<geometrycentral::surface::SurfacePoint>& points,
+                                 const AttributeMatrix& inputAttributes, size_t nThreads);
@@ -0,0 +1,43 @@
+#include "backend_selection.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+MeshFeatures meshFeatures(ManifoldSurfaceMesh& mesh, VertexPositionGeometry& geometry) {
+  MeshFeatures features;
+  features.nVertices = mesh.nVertices();
+
+  geometry.requireCornerAngles();
+  double minAngle = M_PI;
+  for (Corner c : mesh.corners()) minAngle = std::min(minAngle, geometry.cornerAngles[c]);
+  features.minAngleDeg = minAngle * 180. / M_PI;
+  geometry.unrequireCornerAngles();
+
+  // As IntrinsicTriangulation::isDelaunay() tests it
+  const double delaunayEPS = 1e-6;
+  geometry.requireEdgeCotanWeights();
+  for (Edge e : mesh.edges()) {
+    if (geometry.edgeCotanWeights[e] < -delaunayEPS) {
+      features.isDelaunay = false;
+      break;
+    }
+  }
+  geometry.unrequireEdgeCotanWeights();
+
+  return features;
+}
+
+std::string chooseBackend(const MeshFeatures& features, const BackendWorkload& workload,
+                          const BackendSelectionModel& model) {
+  if (features.nVertices < model.minSignpostVertices) return "Integer Coordinates";
+
+  // A Delaunay input which is not refined keeps all of its edges, so its common subdivision is the input mesh itself,
+  // and either backend traces it immediately
+  bool unchanged = features.isDelaunay && !workload.refine;
+  if (workload.traceCommonSubdivision && !unchanged) return "Integer Coordinates";
+  if (workload.refine && features.minAngleDeg < model.minSignpostRefineAngleDeg) return "Integer Coordinates";
+  return "Signposts";
+}
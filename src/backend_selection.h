@@ -0,0 +1,40 @@
+#pragma once
+
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <cstddef>
+#include <string>
+
+// Cheap features of an input mesh, which --backend auto uses to predict which backend will be faster on it. These
+// are the same as the inputVertices, inputMinAngleDeg and inputIsDelaunay statistics.
+struct MeshFeatures {
+  size_t nVertices = 0;
+  double minAngleDeg = 0;
+  bool isDelaunay = true;
+};
+
+// Compute the features of an input mesh in one pass over its corners and one over its edges
+MeshFeatures meshFeatures(geometrycentral::surface::ManifoldSurfaceMesh& mesh,
+                          geometrycentral::surface::VertexPositionGeometry& geometry);
+
+// What a run does with its intrinsic triangulation
+struct BackendWorkload {
+  bool flip = false;
+  bool refine = false;
+  bool traceCommonSubdivision = false;
+};
+
+// Thresholds of the rule chooseBackend() applies, which --backend both logs the data to fit
+struct BackendSelectionModel {
+  // Below this many vertices every backend takes milliseconds, so pick integer coordinates for their robustness
+  size_t minSignpostVertices = 1000;
+  // Refining a mesh with triangles this thin is where signposts are least robust
+  double minSignpostRefineAngleDeg = 1.;
+};
+
+// The backend ("Integer Coordinates" or "Signposts") expected to be faster on a mesh with the given features. Signposts
+// are faster to build and usually to flip, while integer coordinates are more robust and usually faster once the common
+// subdivision is traced, which they read off the normal coordinates rather than tracing geodesics.
+std::string chooseBackend(const MeshFeatures& features, const BackendWorkload& workload,
+                          const BackendSelectionModel& model = BackendSelectionModel());
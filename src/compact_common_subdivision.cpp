@@ -0,0 +1,123 @@
+#include "compact_common_subdivision.h"
+
+#include "parallel.h"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+CompactCommonSubdivision::CompactCommonSubdivision(IntrinsicTriangulation& intTri_, size_t nThreads, bool quantize)
+    : intTri(intTri_), quantized(quantize), nIntrinsicVertices(intTri_.intrinsicMesh->nVertices()) {
+  ManifoldSurfaceMesh& mesh = *intTri.intrinsicMesh;
+  const size_t maxIndex = std::numeric_limits<uint32_t>::max();
+  if (nIntrinsicVertices > maxIndex || intTri.inputMesh.nEdges() > maxIndex) {
+    throw std::runtime_error("mesh is too large for 32-bit common subdivision indices");
+  }
+
+  VertexData<size_t> denseIndex(mesh);
+  size_t iV = 0;
+  for (Vertex v : mesh.vertices()) denseIndex[v] = iV++;
+
+  std::vector<Edge> edges;
+  for (Edge e : mesh.edges()) {
+    edges.push_back(e);
+    edgeTail.push_back(denseIndex[e.firstVertex()]);
+    edgeTip.push_back(denseIndex[e.secondVertex()]);
+  }
+  if (edges.empty()) {
+    edgeStart.assign(1, 0);
+    return;
+  }
+
+  // The backends compute some of the input geometry lazily on first use, which must not happen concurrently
+  intTri.traceIntrinsicHalfedgeAlongInput(edges[0].halfedge());
+
+  // Trace contiguous blocks of edges into per-block buffers, recording how many crossings each edge has
+  size_t nBlocks = std::min(edges.size(), 4 * resolveThreadCount(nThreads));
+  std::vector<size_t> blockStart(nBlocks + 1);
+  for (size_t iB = 0; iB <= nBlocks; iB++) blockStart[iB] = edges.size() * iB / nBlocks;
+  std::vector<std::vector<uint32_t>> blockEdges(nBlocks);
+  std::vector<std::vector<double>> blockT(nBlocks);
+  std::vector<size_t> edgeCount(edges.size());
+  parallelFor(
+      nBlocks,
+      [&](size_t iB) {
+        for (size_t iE = blockStart[iB]; iE < blockStart[iB + 1]; iE++) {
+          std::vector<SurfacePoint> path = intTri.traceIntrinsicHalfedgeAlongInput(edges[iE].halfedge());
+          for (size_t iP = 1; iP + 1 < path.size(); iP++) {
+            if (path[iP].type != SurfacePointType::Edge) {
+              throw std::runtime_error("intrinsic edge " + std::to_string(edges[iE].getIndex()) +
+                                       " passes through an input vertex or face");
+            }
+            blockEdges[iB].push_back(path[iP].edge.getIndex());
+            blockT[iB].push_back(path[iP].tEdge);
+          }
+          edgeCount[iE] = path.size() - 2;
+        }
+      },
+      nThreads, 1);
+
+  // Compact the buffers into the final arrays
+  edgeStart.resize(edges.size() + 1);
+  size_t nTotal = 0;
+  for (size_t iE = 0; iE < edges.size(); iE++) {
+    edgeStart[iE] = nTotal;
+    nTotal += edgeCount[iE];
+    if (nTotal > maxIndex) throw std::runtime_error("common subdivision has too many crossings for 32-bit indices");
+  }
+  edgeStart[edges.size()] = nTotal;
+
+  crossingEdge.resize(nTotal);
+  if (quantized) {
+    crossingTQuantized.resize(nTotal);
+  } else {
+    crossingT.resize(nTotal);
+  }
+  parallelFor(
+      nBlocks,
+      [&](size_t iB) {
+        size_t offset = edgeStart[blockStart[iB]];
+        std::copy(blockEdges[iB].begin(), blockEdges[iB].end(), crossingEdge.begin() + offset);
+        for (size_t iC = 0; iC < blockT[iB].size(); iC++) {
+          if (quantized) {
+            double t = std::max(0., std::min(1., blockT[iB][iC]));
+            crossingTQuantized[offset + iC] = static_cast<uint16_t>(std::lround(t * 65535.));
+          } else {
+            crossingT[offset + iC] = blockT[iB][iC];
+          }
+        }
+        std::vector<uint32_t>().swap(blockEdges[iB]);
+        std::vector<double>().swap(blockT[iB]);
+      },
+      nThreads, 1);
+}
+
+size_t CompactCommonSubdivision::sizeInBytes() const {
+  return (edgeTail.capacity() + edgeTip.capacity() + edgeStart.capacity() + crossingEdge.capacity()) *
+             sizeof(uint32_t) +
+         crossingT.capacity() * sizeof(double) + crossingTQuantized.capacity() * sizeof(uint16_t);
+}
+
+std::string CompactCommonSubdivision::encodeObj(VertexPositionGeometry& inputGeometry) const {
+  std::vector<Vector3> positions = interpolateAcrossA(inputGeometry.inputVertexPositions);
+  std::string out = "# common subdivision edges: " + std::to_string(nIntrinsicVertices) + " intrinsic vertices, " +
+                    std::to_string(nCrossings()) + " crossings\n";
+
+  char buf[128];
+  for (const Vector3& p : positions) {
+    int n = std::snprintf(buf, sizeof(buf), "v %.16g %.16g %.16g\n", p.x, p.y, p.z);
+    out.append(buf, n);
+  }
+  for (size_t iE = 0; iE + 1 < edgeStart.size(); iE++) {
+    out += "l " + std::to_string(edgeTail[iE] + 1);
+    for (size_t iC = edgeStart[iE]; iC < edgeStart[iE + 1]; iC++) {
+      out += " " + std::to_string(nIntrinsicVertices + iC + 1);
+    }
+    out += " " + std::to_string(edgeTip[iE] + 1) + "\n";
+  }
+  return out;
+}
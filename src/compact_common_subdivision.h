@@ -0,0 +1,75 @@
+#pragma once
+
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The vertices and edges of the common subdivision, stored as flat arrays.
+//
+// geometry-central's CommonSubdivision keeps a vector of SurfacePoints per intrinsic edge, and constructMesh() adds a
+// full halfedge mesh on top. Here every point where an intrinsic edge crosses an input edge takes 12 bytes (a 32-bit
+// input edge index and a double parameter along it), or 6 bytes with quantized parameters, and there is no mesh. The
+// endpoints of each intrinsic edge are intrinsic vertices, whose locations the triangulation already stores.
+//
+// The common subdivision's vertices are numbered with the intrinsic vertices first, in mesh order, followed by the
+// crossings in order along each intrinsic edge, the edges in mesh order. Data on the input vertices can be
+// interpolated at all of them, as CommonSubdivision::interpolateAcrossA() does. Face-based transfer (copyFromA(),
+// copyFromB()) needs the subdivision's faces, which this does not build.
+class CompactCommonSubdivision {
+public:
+  // Trace every intrinsic edge over the input mesh on nThreads threads (0 means one per hardware thread). Each thread
+  // appends its edges' crossings to its own buffer, and the buffers are then compacted into the final arrays, so only
+  // one path per thread is ever held as SurfacePoints. If quantize is set, crossing parameters are rounded to 16 bits,
+  // placing each crossing within 1/131070 of its input edge's length (half of the 1/65535 step) of where it lies.
+  // Throws if the subdivision has more than 2^32 - 1 crossings.
+  CompactCommonSubdivision(geometrycentral::surface::IntrinsicTriangulation& intTri, size_t nThreads, bool quantize);
+
+  size_t nVertices() const { return nIntrinsicVertices + nCrossings(); }
+  size_t nCrossings() const { return crossingEdge.size(); }
+  bool isQuantized() const { return quantized; }
+
+  // Approximate bytes used by the arrays
+  size_t sizeInBytes() const;
+
+  // Data on the input vertices, interpolated at every vertex of the common subdivision
+  template <typename T>
+  std::vector<T> interpolateAcrossA(const geometrycentral::surface::VertexData<T>& inputData) const {
+    std::vector<T> values;
+    values.reserve(nVertices());
+    for (geometrycentral::surface::Vertex v : intTri.intrinsicMesh->vertices()) {
+      values.push_back(intTri.vertexLocations[v].interpolate(inputData));
+    }
+    for (size_t iC = 0; iC < nCrossings(); iC++) {
+      geometrycentral::surface::Edge e = intTri.inputMesh.edge(crossingEdge[iC]);
+      double t = crossingParameter(iC);
+      values.push_back((1. - t) * inputData[e.firstVertex()] + t * inputData[e.secondVertex()]);
+    }
+    return values;
+  }
+
+  // The edges of the common subdivision as an OBJ file of polylines, one per intrinsic edge, positioned by
+  // interpolating the input vertex positions
+  std::string encodeObj(geometrycentral::surface::VertexPositionGeometry& inputGeometry) const;
+
+private:
+  double crossingParameter(size_t iC) const {
+    return quantized ? crossingTQuantized[iC] / 65535. : crossingT[iC];
+  }
+
+  geometrycentral::surface::IntrinsicTriangulation& intTri;
+  bool quantized;
+  size_t nIntrinsicVertices;
+
+  // Dense indices of each intrinsic edge's endpoints, and the range of its crossings in the arrays below, in mesh order
+  std::vector<uint32_t> edgeTail, edgeTip;
+  std::vector<uint32_t> edgeStart;
+
+  // For each crossing: the input edge crossed, and the parameter along it from its first vertex (exact or quantized)
+  std::vector<uint32_t> crossingEdge;
+  std::vector<double> crossingT;
+  std::vector<uint16_t> crossingTQuantized;
+};
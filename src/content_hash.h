@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// 64-bit FNV-1a hashes, used to name cache entries, to check that saved state matches its input, and to fingerprint
+// output files. Not cryptographic.
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+// Extend hash with n bytes of data. Start from FNV_OFFSET_BASIS.
+inline uint64_t fnv1aHash(const void* data, size_t n, uint64_t hash = FNV_OFFSET_BASIS) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < n; i++) hash = (hash ^ bytes[i]) * FNV_PRIME;
+  return hash;
+}
+
+inline uint64_t fnv1aHash(const std::string& data) { return fnv1aHash(data.data(), data.size()); }
+
+// A hash as 16 lowercase hex digits
+inline std::string hashToHex(uint64_t hash) {
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+  return hex;
+}
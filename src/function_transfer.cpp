@@ -0,0 +1,84 @@
+#include "function_transfer.h"
+
+#include "parallel.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+FunctionTransfer::FunctionTransfer(CommonSubdivision& cs, VertexPositionGeometry& inputGeometry,
+                                   TransferDirection direction) {
+  if (!cs.mesh) throw std::runtime_error("function transfer needs the common subdivision's mesh");
+  ManifoldSurfaceMesh& csMesh = *cs.mesh;
+
+  SparseMatrix<double> interpolationA = cs.interpolationMatrixA();
+  SparseMatrix<double> interpolationB = cs.interpolationMatrixB();
+  bool toIntrinsic = direction == TransferDirection::InputToIntrinsic;
+  sourceInterpolation = toIntrinsic ? interpolationA : interpolationB;
+  SparseMatrix<double> targetInterpolation = toIntrinsic ? interpolationB : interpolationA;
+  targetInterpolationT = targetInterpolation.transpose();
+
+  // The faces of the common subdivision are flat pieces of input faces, so their areas come from the interpolated
+  // input positions in either direction
+  VertexPositionGeometry csGeometry(csMesh, cs.interpolateAcrossA(inputGeometry.vertexPositions));
+  csGeometry.requireVertexIndices();
+  csGeometry.requireFaceAreas();
+  nSubdivisionVertices = csMesh.nVertices();
+  for (Face f : csMesh.faces()) {
+    std::array<size_t, 3> vertices;
+    int j = 0;
+    for (Vertex v : f.adjacentVertices()) vertices[j++] = csGeometry.vertexIndices[v];
+    faceVertices.push_back(vertices);
+    faceAreas.push_back(csGeometry.faceAreas[f]);
+  }
+
+  // M_T = P_T^T M_C P_T is the only matrix formed, once, to be factored
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(9 * faceVertices.size());
+  for (size_t iF = 0; iF < faceVertices.size(); iF++) {
+    for (int a = 0; a < 3; a++) {
+      for (int b = 0; b < 3; b++) {
+        triplets.emplace_back(faceVertices[iF][a], faceVertices[iF][b], faceAreas[iF] * (a == b ? 2. : 1.) / 12.);
+      }
+    }
+  }
+  SparseMatrix<double> subdivisionMass(nSubdivisionVertices, nSubdivisionVertices);
+  subdivisionMass.setFromTriplets(triplets.begin(), triplets.end());
+  targetMass = targetInterpolationT * subdivisionMass * targetInterpolation;
+  solver.reset(new PositiveDefiniteSolver<double>(targetMass));
+}
+
+Vector<double> FunctionTransfer::applyMixedMass(const Vector<double>& field) const {
+  Vector<double> subdivisionValues = sourceInterpolation * field;
+
+  // Galerkin mass of each face: area / 6 on the diagonal, area / 12 off it
+  Vector<double> integrals = Vector<double>::Zero(nSubdivisionVertices);
+  for (size_t iF = 0; iF < faceVertices.size(); iF++) {
+    const std::array<size_t, 3>& vertices = faceVertices[iF];
+    double sum = subdivisionValues[vertices[0]] + subdivisionValues[vertices[1]] + subdivisionValues[vertices[2]];
+    for (size_t iV : vertices) integrals[iV] += faceAreas[iF] / 12. * (sum + subdivisionValues[iV]);
+  }
+
+  return targetInterpolationT * integrals;
+}
+
+DenseMatrix<double> FunctionTransfer::transfer(const DenseMatrix<double>& fields, size_t nThreads) {
+  if ((size_t)fields.rows() != nSourceVertices()) {
+    throw std::runtime_error("cannot transfer functions with " + std::to_string(fields.rows()) +
+                             " values from a triangulation with " + std::to_string(nSourceVertices()) + " vertices");
+  }
+
+  size_t nFields = fields.cols();
+  DenseMatrix<double> rhs(nTargetVertices(), nFields);
+  parallelFor(
+      nFields, [&](size_t iField) { rhs.col(iField) = applyMixedMass(fields.col(iField)); }, nThreads, 1);
+
+  DenseMatrix<double> result(nTargetVertices(), nFields);
+  for (size_t iField = 0; iField < nFields; iField++) {
+    Vector<double> column = rhs.col(iField);
+    result.col(iField) = solver->solve(column);
+  }
+  return result;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "geometrycentral/numerical/linear_solvers.h"
+#include "geometrycentral/surface/common_subdivision.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Which way functions are transferred: from the input mesh (geometry-central's mesh A) to the intrinsic triangulation
+// (mesh B), or back
+enum class TransferDirection { InputToIntrinsic, IntrinsicToInput };
+
+// L2-optimal transfer of functions across the common subdivision, in one direction, for any number of functions.
+//
+// AttributeTransfer solves M_T x = M_TS f for each function f, where M_T is the Galerkin mass matrix of the target
+// triangulation and M_TS is the mixed mass matrix of the source and target hat functions, both integrated over the
+// common subdivision. It builds the matrices for both directions, and factors M_T again for every function. Here M_T is
+// built and factored once, for the requested direction only, and M_TS is never formed: it is applied as
+// P_T^T M_C P_S, interpolating a function to the vertices of the common subdivision, integrating it against their hat
+// functions face by face, and summing the result onto the target vertices. Each function then costs one pass over the
+// common subdivision and one back-substitution.
+class FunctionTransfer {
+public:
+  // Set up transfer across cs, which must have its mesh built, with its vertices positioned by interpolating the input
+  // vertex positions. Factors the target's mass matrix.
+  FunctionTransfer(geometrycentral::surface::CommonSubdivision& cs,
+                   geometrycentral::surface::VertexPositionGeometry& inputGeometry, TransferDirection direction);
+
+  size_t nSourceVertices() const { return sourceInterpolation.cols(); }
+  size_t nTargetVertices() const { return targetInterpolationT.rows(); }
+
+  // Transfer each column of fields, a function with one value per source vertex in vertex index order, to the target.
+  // The right-hand sides are assembled on nThreads threads (0 means one per hardware thread), one function per task;
+  // the solves share the factorization, and run one after another. Throws if fields has the wrong number of rows.
+  geometrycentral::DenseMatrix<double> transfer(const geometrycentral::DenseMatrix<double>& fields,
+                                                size_t nThreads = 1);
+
+private:
+  // M_TS f, computed without forming M_TS
+  geometrycentral::Vector<double> applyMixedMass(const geometrycentral::Vector<double>& field) const;
+
+  // P_S, mapping source vertex values to common subdivision vertex values, and P_T^T, summing values on the common
+  // subdivision's vertices onto the target vertices
+  geometrycentral::SparseMatrix<double> sourceInterpolation;
+  geometrycentral::SparseMatrix<double> targetInterpolationT;
+
+  // Vertex indices and area of each face of the common subdivision
+  std::vector<std::array<size_t, 3>> faceVertices;
+  std::vector<double> faceAreas;
+  size_t nSubdivisionVertices;
+
+  geometrycentral::SparseMatrix<double> targetMass;
+  std::unique_ptr<geometrycentral::PositiveDefiniteSolver<double>> solver;
+};
@@ -0,0 +1,206 @@
+#include "int_tri.h"
+
+#include "triangulation_pipeline.h"
+
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+struct int_tri_pipeline {
+  TriangulationPipeline pipeline;
+  std::string lastError;
+
+  // Set by int_tri_cancel(), and cleared once the flips or refinement it stops return
+  std::atomic<bool> cancelled{false};
+
+  int_tri_pipeline() { pipeline.cancel = &cancelled; }
+};
+
+namespace {
+
+// Run body, turning any exception into an error status with its message recorded on the pipeline, so that no
+// exception crosses the C interface
+template <typename F>
+int guarded(int_tri_pipeline* p, F body) {
+  if (!p) return INT_TRI_ERROR;
+  try {
+    body(p->pipeline);
+    return INT_TRI_OK;
+  } catch (const std::exception& e) {
+    p->lastError = e.what();
+  } catch (...) {
+    p->lastError = "unknown error";
+  }
+  return INT_TRI_ERROR;
+}
+
+void viewMatrix(const Eigen::SparseMatrix<double, Eigen::RowMajor>& source, int_tri_csr_matrix* matrix) {
+  if (!matrix) throw std::invalid_argument("no matrix to fill in");
+  if (!source.isCompressed()) throw std::logic_error("matrix is not compressed");
+  matrix->rows = source.rows();
+  matrix->cols = source.cols();
+  matrix->nnz = source.nonZeros();
+  matrix->rowStart = source.outerIndexPtr();
+  matrix->columns = source.innerIndexPtr();
+  matrix->values = source.valuePtr();
+}
+
+// Check that a caller's buffer has room for count elements of an existing triangulation, before anything is written
+void checkBufferSize(const TriangulationPipeline& p, size_t bufferCount, size_t count, std::string what) {
+  if (!p.hasTriangulation()) throw std::logic_error("there is no intrinsic triangulation yet");
+  if (bufferCount != count) {
+    throw std::invalid_argument("buffer holds " + std::to_string(bufferCount) + " " + what +
+                                ", but the triangulation has " + std::to_string(count));
+  }
+}
+
+} // namespace
+
+int_tri_pipeline* int_tri_create(void) { return new (std::nothrow) int_tri_pipeline(); }
+
+void int_tri_destroy(int_tri_pipeline* pipeline) { delete pipeline; }
+
+const char* int_tri_last_error(const int_tri_pipeline* pipeline) {
+  return pipeline ? pipeline->lastError.c_str() : "no pipeline";
+}
+
+int int_tri_set_threads(int_tri_pipeline* pipeline, size_t nThreads) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) { p.nThreads = nThreads; });
+}
+
+int int_tri_load_mesh(int_tri_pipeline* pipeline, const char* filename, int triangulate) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    if (!filename) throw std::invalid_argument("no mesh filename");
+    p.loadMesh(filename, triangulate != 0);
+  });
+}
+
+int int_tri_set_mesh(int_tri_pipeline* pipeline, const double* vertexPositions, size_t nVertices,
+                     const uint64_t* triangles, size_t nTriangles) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    if (!vertexPositions || !triangles) throw std::invalid_argument("missing vertex positions or triangles");
+    std::vector<size_t> corners(triangles, triangles + 3 * nTriangles);
+    p.setMesh(vertexPositions, nVertices, corners.data(), nTriangles);
+  });
+}
+
+int int_tri_reset_triangulation(int_tri_pipeline* pipeline, const char* backend) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    std::string name = backend ? backend : "integer";
+    if (name == "integer") {
+      p.resetTriangulation("Integer Coordinates");
+    } else if (name == "signpost") {
+      p.resetTriangulation("Signposts");
+    } else {
+      throw std::invalid_argument("unrecognized backend '" + name + "'. Please use 'signpost' or 'integer'");
+    }
+  });
+}
+
+int int_tri_flip_to_delaunay(int_tri_pipeline* pipeline) {
+  int status = guarded(pipeline, [&](TriangulationPipeline& p) { p.flipToDelaunay(); });
+  if (pipeline) pipeline->cancelled.store(false);
+  return status;
+}
+
+int int_tri_refine_delaunay(int_tri_pipeline* pipeline, double angleDegrees, double circumradius,
+                            int64_t maxInsertions) {
+  int status = guarded(pipeline, [&](TriangulationPipeline& p) {
+    size_t limit = maxInsertions > 0 ? (size_t)maxInsertions : INVALID_IND;
+    if (maxInsertions < 0) limit = (size_t)(-maxInsertions) * p.inputMesh().nVertices();
+    p.refineDelaunay(angleDegrees, circumradius, limit);
+  });
+  if (pipeline) pipeline->cancelled.store(false);
+  return status;
+}
+
+int int_tri_set_time_budgets(int_tri_pipeline* pipeline, double flipSeconds, double refineSeconds) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    p.flipTimeBudget = !(flipSeconds >= 0) ? std::numeric_limits<double>::infinity() : flipSeconds;
+    p.refineTimeBudget = !(refineSeconds >= 0) ? std::numeric_limits<double>::infinity() : refineSeconds;
+  });
+}
+
+int int_tri_cancel(int_tri_pipeline* pipeline) {
+  if (!pipeline) return INT_TRI_ERROR;
+  pipeline->cancelled.store(true);
+  return INT_TRI_OK;
+}
+
+const char* int_tri_flip_status(const int_tri_pipeline* pipeline) {
+  return pipeline ? pipeline->pipeline.flipStatus().c_str() : "";
+}
+
+const char* int_tri_refine_status(const int_tri_pipeline* pipeline) {
+  return pipeline ? pipeline->pipeline.refineStatus().c_str() : "";
+}
+
+size_t int_tri_num_input_vertices(const int_tri_pipeline* pipeline) {
+  return pipeline ? pipeline->pipeline.nInputVertices() : 0;
+}
+
+size_t int_tri_num_vertices(const int_tri_pipeline* pipeline) { return pipeline ? pipeline->pipeline.nVertices() : 0; }
+
+size_t int_tri_num_faces(const int_tri_pipeline* pipeline) { return pipeline ? pipeline->pipeline.nFaces() : 0; }
+
+int int_tri_get_faces(int_tri_pipeline* pipeline, uint64_t* faceVertices, double* faceLengths, size_t nFaces) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    if (!faceVertices) throw std::invalid_argument("no buffer for the face vertices");
+    checkBufferSize(p, nFaces, p.nFaces(), "faces");
+    IntrinsicOutputs request;
+    request.intrinsicFaces = true;
+    const IntrinsicOutputBuffers& buffers = p.assemble(request);
+    for (Eigen::Index iF = 0; iF < buffers.faceInds.rows(); iF++) {
+      for (int c = 0; c < 3; c++) {
+        faceVertices[3 * iF + c] = buffers.faceInds(iF, c);
+        if (faceLengths) faceLengths[3 * iF + c] = buffers.faceLengths(iF, c);
+      }
+    }
+  });
+}
+
+int int_tri_get_vertex_positions(int_tri_pipeline* pipeline, double* vertexPositions, size_t nVertices) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    if (!vertexPositions) throw std::invalid_argument("no buffer for the vertex positions");
+    checkBufferSize(p, nVertices, p.nVertices(), "vertices");
+    IntrinsicOutputs request;
+    request.vertexPositions = true;
+    const IntrinsicOutputBuffers& buffers = p.assemble(request);
+    for (Eigen::Index iV = 0; iV < buffers.vertexPositions.rows(); iV++) {
+      for (int c = 0; c < 3; c++) vertexPositions[3 * iV + c] = buffers.vertexPositions(iV, c);
+    }
+  });
+}
+
+int int_tri_view_laplacian(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    IntrinsicOutputs request;
+    request.laplaceMat = true;
+    p.assemble(request);
+    viewMatrix(p.laplacian(), matrix);
+  });
+}
+
+int int_tri_view_mass_matrix(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    IntrinsicOutputs request;
+    request.massMat = true;
+    p.assemble(request);
+    viewMatrix(p.lumpedMass(), matrix);
+  });
+}
+
+int int_tri_view_interpolation_matrix(int_tri_pipeline* pipeline, int_tri_csr_matrix* matrix) {
+  return guarded(pipeline, [&](TriangulationPipeline& p) {
+    IntrinsicOutputs request;
+    request.interpolateMat = true;
+    viewMatrix(p.assemble(request).interpolate, matrix);
+  });
+}
@@ -0,0 +1,107 @@
+#include "intrinsic_outputs.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+void assembleIntrinsicOutputs(const IntrinsicView& view, const VertexData<Vector3>& inputPositions,
+                              const IntrinsicOutputs& request, IntrinsicOutputBuffers& buffers, size_t nThreads) {
+  EdgeLengthGeometry& geometry = view.geometry;
+
+  geometry.requireVertexIndices();
+  geometry.requireEdgeLengths();
+
+  // Fx3 matrices of the vertex indices and edge lengths of each face
+  if (request.intrinsicFaces) {
+    size_t nF = view.mesh.nFaces();
+    buffers.faceInds.resize(nF, 3);
+    buffers.faceLengths.resize(nF, 3);
+
+    std::vector<Face> faces;
+    faces.reserve(nF);
+    for (Face f : view.mesh.faces()) faces.push_back(f);
+
+    parallelFor(
+        nF,
+        [&](size_t iF) {
+          Halfedge he = faces[iF].halfedge();
+          for (int v = 0; v < 3; v++) {
+            buffers.faceLengths(iF, v) = geometry.edgeLengths[he.edge()];
+            buffers.faceInds(iF, v) = geometry.vertexIndices[he.vertex()];
+            he = he.next();
+          }
+        },
+        nThreads);
+  }
+
+  // Vertex positions and the interpolation matrix both come from the location of each intrinsic vertex in an input
+  // face. Each row of the interpolation matrix holds the (at most 3) positive barycentric coordinates of that location,
+  // so the vertex pass records each row's entries, and the rows are then packed into CSR form using a prefix sum of
+  // their sizes, with no triplets and no sort.
+  if (request.vertexPositions || request.interpolateMat) {
+    size_t nV = view.mesh.nVertices();
+    if (request.vertexPositions) buffers.vertexPositions.resize(nV, 3);
+
+    std::vector<Vertex> vertices;
+    vertices.reserve(nV);
+    for (Vertex v : view.mesh.vertices()) vertices.push_back(v);
+
+    typedef std::array<std::pair<int, double>, 3> RowEntries;
+    std::vector<RowEntries> rows(request.interpolateMat ? nV : 0);
+    std::vector<int> rowStart(request.interpolateMat ? nV + 1 : 0, 0);
+
+    parallelFor(
+        nV,
+        [&](size_t iV) {
+          SurfacePoint p = view.vertexLocations[vertices[iV]].inSomeFace();
+
+          if (request.vertexPositions) {
+            Vector3 pos = p.interpolate(inputPositions);
+            buffers.vertexPositions(iV, 0) = pos.x;
+            buffers.vertexPositions(iV, 1) = pos.y;
+            buffers.vertexPositions(iV, 2) = pos.z;
+          }
+
+          if (request.interpolateMat) {
+            RowEntries& entries = rows[iV];
+            int nEntries = 0;
+            int j = 0;
+            for (Vertex n : p.face.adjacentVertices()) {
+              double w = p.faceCoords[j];
+              if (w > 0) entries[nEntries++] = std::make_pair((int)geometry.vertexIndices[n], w);
+              j++;
+            }
+
+            // Compressed rows must list their columns in increasing order
+            std::sort(entries.begin(), entries.begin() + nEntries);
+            rowStart[iV + 1] = nEntries;
+          }
+        },
+        nThreads);
+
+    if (request.interpolateMat) {
+      for (size_t iV = 0; iV < nV; iV++) rowStart[iV + 1] += rowStart[iV];
+
+      Eigen::SparseMatrix<double, Eigen::RowMajor>& interpMat = buffers.interpolate;
+      interpMat.resize(nV, nV);
+      interpMat.resizeNonZeros(rowStart[nV]);
+      std::copy(rowStart.begin(), rowStart.end(), interpMat.outerIndexPtr());
+      int* cols = interpMat.innerIndexPtr();
+      double* vals = interpMat.valuePtr();
+
+      parallelFor(
+          nV,
+          [&](size_t iV) {
+            for (int iE = 0; iE < rowStart[iV + 1] - rowStart[iV]; iE++) {
+              cols[rowStart[iV] + iE] = rows[iV][iE].first;
+              vals[rowStart[iV] + iE] = rows[iV][iE].second;
+            }
+          },
+          nThreads);
+    }
+  }
+}
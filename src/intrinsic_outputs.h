@@ -0,0 +1,44 @@
+#pragma once
+
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/surface_point.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <Eigen/Sparse>
+
+#include <cstddef>
+
+// An intrinsic triangulation whose outputs are assembled: either an IntrinsicTriangulation, or one loaded with
+// loadIntrinsicTriangulation()
+struct IntrinsicView {
+  geometrycentral::surface::ManifoldSurfaceMesh& mesh;
+  geometrycentral::surface::EdgeLengthGeometry& geometry;
+  const geometrycentral::surface::VertexData<geometrycentral::surface::SurfacePoint>& vertexLocations;
+};
+
+// Outputs which only depend on the intrinsic triangulation, and not on the common subdivision
+struct IntrinsicOutputs {
+  bool intrinsicFaces = false;
+  bool vertexPositions = false;
+  bool laplaceMat = false;
+  bool massMat = false;
+  bool interpolateMat = false;
+
+  bool any() const { return intrinsicFaces || vertexPositions || laplaceMat || massMat || interpolateMat; }
+};
+
+// Buffers holding the intrinsic outputs assembled by assembleIntrinsicOutputs(). The Laplacian and mass matrices
+// come from a LaplacianAssembler instead, which keeps them up to date across edits.
+struct IntrinsicOutputBuffers {
+  geometrycentral::DenseMatrix<size_t> faceInds;            // vertex indices of each face's corners
+  geometrycentral::DenseMatrix<double> faceLengths;         // length of the edge following each corner
+  geometrycentral::DenseMatrix<double> vertexPositions;     // position of each vertex on the input surface
+  Eigen::SparseMatrix<double, Eigen::RowMajor> interpolate; // barycentric coordinates of each vertex in its input face
+};
+
+// Fill the buffers for the requested faces, vertex positions and interpolation matrix with one parallel pass over the
+// intrinsic faces and one over the intrinsic vertices, on nThreads threads (0 means one per hardware thread).
+// Intrinsic vertices are positioned by interpolating inputPositions.
+void assembleIntrinsicOutputs(const IntrinsicView& view,
+                              const geometrycentral::surface::VertexData<geometrycentral::Vector3>& inputPositions,
+                              const IntrinsicOutputs& request, IntrinsicOutputBuffers& buffers, size_t nThreads);
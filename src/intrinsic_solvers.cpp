@@ -0,0 +1,48 @@
+#include "intrinsic_solvers.h"
+
+#include "geometrycentral/numerical/linear_algebra_utilities.h"
+#include "geometrycentral/surface/heat_method_distance.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+PoissonSolver::PoissonSolver(const Eigen::SparseMatrix<double, Eigen::RowMajor>& laplacian,
+                             const Eigen::SparseMatrix<double, Eigen::RowMajor>& lumpedMass) {
+  size_t n = laplacian.rows();
+  shiftedLaplacian = SparseMatrix<double>(laplacian) + 1e-8 * identityMatrix<double>(n);
+  solver.reset(new PositiveDefiniteSolver<double>(shiftedLaplacian));
+  mass = lumpedMass.diagonal();
+}
+
+DenseMatrix<double> PoissonSolver::solve(const DenseMatrix<double>& rhs) {
+  if ((size_t)rhs.rows() != nVertices()) {
+    throw std::runtime_error("cannot solve for a right-hand side with " + std::to_string(rhs.rows()) +
+                             " rows on a triangulation with " + std::to_string(nVertices()) + " vertices");
+  }
+
+  double totalMass = mass.sum();
+  DenseMatrix<double> solution(rhs.rows(), rhs.cols());
+  for (Eigen::Index iC = 0; iC < rhs.cols(); iC++) {
+    Vector<double> b = rhs.col(iC);
+    b.array() -= b.mean();
+    Vector<double> x = solver->solve(b);
+    x.array() -= mass.dot(x) / totalMass;
+    solution.col(iC) = x;
+  }
+  return solution;
+}
+
+DenseMatrix<double> heatGeodesicDistances(IntrinsicGeometryInterface& geometry,
+                                          const std::vector<std::vector<Vertex>>& sourceSets) {
+  HeatMethodDistanceSolver heatSolver(geometry);
+  DenseMatrix<double> distances(geometry.mesh.nVertices(), sourceSets.size());
+  for (size_t iS = 0; iS < sourceSets.size(); iS++) {
+    VertexData<double> distance = heatSolver.computeDistance(sourceSets[iS]);
+    size_t iV = 0;
+    for (Vertex v : geometry.mesh.vertices()) distances(iV++, iS) = distance[v];
+  }
+  return distances;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "geometrycentral/numerical/linear_solvers.h"
+#include "geometrycentral/surface/intrinsic_geometry_interface.h"
+
+#include <Eigen/Sparse>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Solves the Poisson equation L x = b with the cotan Laplacian of a triangulation, for any number of right-hand sides.
+//
+// L is factored once, in the constructor, shifted by 1e-8 times the identity (as geometry-central's heat method does)
+// since the Laplacian of a closed or Neumann surface is singular. Each b is given in weak form, integrated around its
+// vertices as L x is, and any constant part is removed first, so that the system is consistent. Solutions are only
+// defined up to a constant, and are returned with zero mean under the lumped mass matrix.
+class PoissonSolver {
+public:
+  PoissonSolver(const Eigen::SparseMatrix<double, Eigen::RowMajor>& laplacian,
+                const Eigen::SparseMatrix<double, Eigen::RowMajor>& lumpedMass);
+
+  size_t nVertices() const { return mass.size(); }
+
+  // Solve for each column of rhs, one row per vertex. Throws if rhs has the wrong number of rows.
+  geometrycentral::DenseMatrix<double> solve(const geometrycentral::DenseMatrix<double>& rhs);
+
+private:
+  geometrycentral::SparseMatrix<double> shiftedLaplacian;
+  std::unique_ptr<geometrycentral::PositiveDefiniteSolver<double>> solver;
+  geometrycentral::Vector<double> mass;
+};
+
+// Geodesic distance from each set of source vertices, by the heat method, as one column per set with one row per
+// vertex in mesh order. The heat flow and Poisson systems are factored once for all of the sets.
+geometrycentral::DenseMatrix<double>
+heatGeodesicDistances(geometrycentral::surface::IntrinsicGeometryInterface& geometry,
+                      const std::vector<std::vector<geometrycentral::surface::Vertex>>& sourceSets);
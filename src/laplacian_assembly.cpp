@@ -0,0 +1,208 @@
+#include "laplacian_assembly.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+namespace {
+
+// Area of a triangle with side lengths a, b, c, by Heron's formula
+double triangleArea(double a, double b, double c) {
+  return 0.25 * std::sqrt(std::max(0., (a + b + c) * (-a + b + c) * (a - b + c) * (a + b - c)));
+}
+
+// One row of the Laplacian, as (column, value) pairs in increasing column order
+typedef std::vector<std::pair<int, double>> RowEntries;
+
+} // namespace
+
+LaplacianAssembler::LaplacianAssembler(ManifoldSurfaceMesh& mesh_, const EdgeData<double>& edgeLengths_)
+    : mesh(mesh_), edgeLengths(edgeLengths_) {}
+
+LaplacianAssembler::FaceStamp LaplacianAssembler::stampOf(Face f) const {
+  FaceStamp stamp;
+  Halfedge he = f.halfedge();
+  for (int c = 0; c < 3; c++) {
+    stamp.halfedges[c] = he.getIndex();
+    stamp.vertices[c] = he.vertex().getIndex();
+    stamp.lengths[c] = edgeLengths[he.edge()];
+    he = he.next();
+  }
+  return stamp;
+}
+
+size_t LaplacianAssembler::update(size_t nThreads) {
+  std::vector<Vertex> vertices;
+  std::vector<Face> faces;
+  vertices.reserve(mesh.nVertices());
+  faces.reserve(mesh.nFaces());
+  for (Vertex v : mesh.vertices()) vertices.push_back(v);
+  for (Face f : mesh.faces()) faces.push_back(f);
+  size_t n = vertices.size();
+
+  // Number the vertices in mesh order. Rows are only reused if every vertex which had one keeps its number, as after
+  // flips, or insertions which append vertices; otherwise everything is recomputed.
+  std::vector<size_t> newRowOfVertex(mesh.nVerticesCapacity(), INVALID_IND);
+  std::vector<char> rowDirty(n, false);
+  size_t nKept = 0;
+  bool rebuild = false;
+  for (size_t iV = 0; iV < n; iV++) {
+    size_t index = vertices[iV].getIndex();
+    size_t oldRow = index < rowOfVertex.size() ? rowOfVertex[index] : INVALID_IND;
+    newRowOfVertex[index] = iV;
+    if (oldRow == INVALID_IND) {
+      rowDirty[iV] = true;
+    } else {
+      nKept++;
+      rebuild = rebuild || oldRow != iV;
+    }
+  }
+  rebuild = rebuild || nKept != (size_t)L.rows();
+  rowOfVertex.swap(newRowOfVertex);
+  if (rebuild) rowDirty.assign(n, true);
+
+  // Recompute the weights of every face whose stamp changed. Each face writes only its own slots and those of its
+  // halfedges, so faces can be processed concurrently.
+  faceStamps.resize(mesh.nFacesCapacity());
+  faceAreas.resize(mesh.nFacesCapacity(), 0.);
+  halfCotans.resize(mesh.nHalfedgesCapacity(), 0.);
+  std::vector<char> faceChanged(faces.size(), false);
+  parallelFor(
+      faces.size(),
+      [&](size_t iF) {
+        size_t index = faces[iF].getIndex();
+        FaceStamp stamp = stampOf(faces[iF]);
+        if (!rebuild && stamp == faceStamps[index]) return;
+        faceChanged[iF] = true;
+        faceStamps[index] = stamp;
+
+        const std::array<double, 3>& l = stamp.lengths;
+        double area = triangleArea(l[0], l[1], l[2]);
+        faceAreas[index] = area;
+        for (int c = 0; c < 3; c++) {
+          double a = l[c];
+          double b = l[(c + 1) % 3];
+          double d = l[(c + 2) % 3];
+          halfCotans[stamp.halfedges[c]] = (b * b + d * d - a * a) / (8 * area);
+        }
+      },
+      nThreads);
+
+  for (size_t iF = 0; iF < faces.size(); iF++) {
+    if (!faceChanged[iF]) continue;
+    for (Vertex v : faces[iF].adjacentVertices()) rowDirty[rowOfVertex[v.getIndex()]] = true;
+  }
+  std::vector<size_t> dirtyRows;
+  for (size_t iV = 0; iV < n; iV++) {
+    if (rowDirty[iV]) dirtyRows.push_back(iV);
+  }
+  if (dirtyRows.empty()) return 0;
+
+  // Gather each dirty row from the halfedges around its vertex. An edge ij contributes its weight to L_ii and its
+  // negation to L_ij; parallel edges are merged, and a self-edge's contributions cancel.
+  std::vector<RowEntries> newRows(dirtyRows.size());
+  std::vector<double> newMass(dirtyRows.size());
+  parallelFor(
+      dirtyRows.size(),
+      [&](size_t iD) {
+        RowEntries& row = newRows[iD];
+        double diagonal = 0;
+        double mass = 0;
+        for (Halfedge he : vertices[dirtyRows[iD]].outgoingHalfedges()) {
+          double w = 0;
+          if (he.isInterior()) {
+            w += halfCotans[he.getIndex()];
+            mass += faceAreas[he.face().getIndex()] / 3.;
+          }
+          if (he.twin().isInterior()) w += halfCotans[he.twin().getIndex()];
+          row.emplace_back((int)rowOfVertex[he.tipVertex().getIndex()], -w);
+          diagonal += w;
+        }
+        row.emplace_back((int)dirtyRows[iD], diagonal);
+
+        std::sort(row.begin(), row.end());
+        size_t nMerged = 0;
+        for (size_t iE = 0; iE < row.size(); iE++) {
+          if (nMerged > 0 && row[nMerged - 1].first == row[iE].first) {
+            row[nMerged - 1].second += row[iE].second;
+          } else {
+            row[nMerged++] = row[iE];
+          }
+        }
+        row.resize(nMerged);
+        newMass[iD] = mass;
+      },
+      nThreads);
+
+  // Write the rows in place if none changed shape, and otherwise repack, copying the clean rows across
+  bool inPlace = !rebuild && (size_t)L.rows() == n;
+  for (size_t iD = 0; iD < dirtyRows.size() && inPlace; iD++) {
+    const int* outer = L.outerIndexPtr();
+    const int* cols = L.innerIndexPtr() + outer[dirtyRows[iD]];
+    const RowEntries& row = newRows[iD];
+    inPlace = (size_t)(outer[dirtyRows[iD] + 1] - outer[dirtyRows[iD]]) == row.size();
+    for (size_t iE = 0; iE < row.size() && inPlace; iE++) inPlace = cols[iE] == row[iE].first;
+  }
+
+  if (inPlace) {
+    parallelFor(
+        dirtyRows.size(),
+        [&](size_t iD) {
+          double* vals = L.valuePtr() + L.outerIndexPtr()[dirtyRows[iD]];
+          for (size_t iE = 0; iE < newRows[iD].size(); iE++) vals[iE] = newRows[iD][iE].second;
+        },
+        nThreads);
+  } else {
+    std::vector<size_t> dirtyIndex(n, INVALID_IND);
+    for (size_t iD = 0; iD < dirtyRows.size(); iD++) dirtyIndex[dirtyRows[iD]] = iD;
+    const int* oldOuter = L.outerIndexPtr();
+
+    std::vector<int> rowStart(n + 1, 0);
+    for (size_t r = 0; r < n; r++) {
+      int size = dirtyIndex[r] != INVALID_IND ? newRows[dirtyIndex[r]].size() : oldOuter[r + 1] - oldOuter[r];
+      rowStart[r + 1] = rowStart[r] + size;
+    }
+
+    Eigen::SparseMatrix<double, Eigen::RowMajor> packed(n, n);
+    packed.resizeNonZeros(rowStart[n]);
+    std::copy(rowStart.begin(), rowStart.end(), packed.outerIndexPtr());
+    int* cols = packed.innerIndexPtr();
+    double* vals = packed.valuePtr();
+    parallelFor(
+        n,
+        [&](size_t r) {
+          if (dirtyIndex[r] != INVALID_IND) {
+            const RowEntries& row = newRows[dirtyIndex[r]];
+            for (size_t iE = 0; iE < row.size(); iE++) {
+              cols[rowStart[r] + iE] = row[iE].first;
+              vals[rowStart[r] + iE] = row[iE].second;
+            }
+          } else {
+            std::copy(L.innerIndexPtr() + oldOuter[r], L.innerIndexPtr() + oldOuter[r + 1], cols + rowStart[r]);
+            std::copy(L.valuePtr() + oldOuter[r], L.valuePtr() + oldOuter[r + 1], vals + rowStart[r]);
+          }
+        },
+        nThreads);
+    L.swap(packed);
+  }
+
+  // The mass matrix keeps its diagonal pattern, growing with the vertex count
+  if ((size_t)M.rows() != n) {
+    Eigen::SparseMatrix<double, Eigen::RowMajor> resized(n, n);
+    resized.resizeNonZeros(n);
+    for (size_t r = 0; r <= n; r++) resized.outerIndexPtr()[r] = r;
+    for (size_t r = 0; r < n; r++) {
+      resized.innerIndexPtr()[r] = r;
+      resized.valuePtr()[r] = r < (size_t)M.rows() ? M.valuePtr()[r] : 0.;
+    }
+    M.swap(resized);
+  }
+  for (size_t iD = 0; iD < dirtyRows.size(); iD++) M.valuePtr()[dirtyRows[iD]] = newMass[iD];
+
+  return dirtyRows.size();
+}
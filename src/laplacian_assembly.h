@@ -0,0 +1,61 @@
+#pragma once
+
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+
+#include <Eigen/Sparse>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// The cotan Laplacian and lumped mass matrix of a triangulation given by its edge lengths, kept up to date across edits.
+//
+// geometry-central's requireCotanLaplacian() gathers triplets from every halfedge and sorts them each time the matrix
+// is needed. Here each face's half-cotangent weights and area are computed directly from the edge lengths, in
+// parallel, and every row is gathered from the halfedges around its vertex into a CSR matrix. Both are cached: each
+// face is stamped with its halfedges, vertices and edge lengths, and update() only recomputes the faces whose stamp
+// changed and the rows of their vertices. Rows which keep their sparsity pattern are updated in place; if any changes
+// shape, the matrix is repacked, copying the other rows as they are.
+//
+// Rows and columns follow the vertices in mesh order, as geometry-central's vertexIndices number them. The Laplacian
+// is positive semidefinite, with L_ij = -(cot a_ij + cot b_ij) / 2 for each edge ij, matching cotanLaplacian up to
+// rounding. The lumped mass matrix is diagonal, holding a third of the area of the faces around each vertex, as
+// vertexLumpedMassMatrix does.
+class LaplacianAssembler {
+public:
+  // edgeLengths must stay valid, and follow the mesh, for as long as the assembler is used
+  LaplacianAssembler(geometrycentral::surface::ManifoldSurfaceMesh& mesh,
+                     const geometrycentral::surface::EdgeData<double>& edgeLengths);
+
+  // Bring both matrices up to date with the mesh, on nThreads threads (0 means one per hardware thread). Returns the
+  // number of rows recomputed.
+  size_t update(size_t nThreads = 1);
+
+  const Eigen::SparseMatrix<double, Eigen::RowMajor>& laplacian() const { return L; }
+  const Eigen::SparseMatrix<double, Eigen::RowMajor>& lumpedMass() const { return M; }
+
+private:
+  // A face's halfedges, their tail vertices and their edge lengths, as they were when its weights were computed
+  struct FaceStamp {
+    std::array<size_t, 3> halfedges = {{geometrycentral::INVALID_IND, geometrycentral::INVALID_IND,
+                                        geometrycentral::INVALID_IND}};
+    std::array<size_t, 3> vertices = {{geometrycentral::INVALID_IND, geometrycentral::INVALID_IND,
+                                       geometrycentral::INVALID_IND}};
+    std::array<double, 3> lengths = {{-1, -1, -1}};
+    bool operator==(const FaceStamp& other) const {
+      return halfedges == other.halfedges && vertices == other.vertices && lengths == other.lengths;
+    }
+  };
+  FaceStamp stampOf(geometrycentral::surface::Face f) const;
+
+  geometrycentral::surface::ManifoldSurfaceMesh& mesh;
+  const geometrycentral::surface::EdgeData<double>& edgeLengths;
+
+  // Per-element caches, indexed by element index
+  std::vector<FaceStamp> faceStamps;
+  std::vector<double> faceAreas;
+  std::vector<double> halfCotans; // half the cotangent of the angle opposite each interior halfedge
+  std::vector<size_t> rowOfVertex;
+
+  Eigen::SparseMatrix<double, Eigen::RowMajor> L, M;
+};
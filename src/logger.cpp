@@ -1,5 +1,17 @@
 #include "logger.h"
 
+#include "memory_usage.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h> // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
 std::string to_string(LogType lot) {
   switch (lot) {
   case LogType::STRING:
@@ -44,28 +56,53 @@ void Logger::log(std::string name, int val) {
 
 void Logger::logString(std::string name, std::string val) {
   // Try to update an existing field
-  for (const std::tuple<std::string, LogType, size_t>& log : logs) {
-    if (std::get<0>(log) == name && std::get<1>(log) == LogType::STRING) {
-      stringLogs[std::get<2>(log)] = val;
-      return;
-    }
+  auto it = stringFields.find(name);
+  if (it != stringFields.end()) {
+    stringLogs[std::get<2>(logs[it->second])] = val;
+    return;
   }
 
+  stringFields[name] = logs.size();
   logs.push_back(std::make_tuple(name, LogType::STRING, stringLogs.size()));
   stringLogs.push_back(val);
 }
 void Logger::logDouble(std::string name, double val) {
   // Try to update an existing field
-  for (const std::tuple<std::string, LogType, size_t>& log : logs) {
-    if (std::get<0>(log) == name && std::get<1>(log) == LogType::DOUBLE) {
-      doubleLogs[std::get<2>(log)] = val;
-      return;
-    }
+  auto it = doubleFields.find(name);
+  if (it != doubleFields.end()) {
+    doubleLogs[std::get<2>(logs[it->second])] = val;
+    return;
   }
+
+  doubleFields[name] = logs.size();
   logs.push_back(std::make_tuple(name, LogType::DOUBLE, doubleLogs.size()));
   doubleLogs.push_back(val);
 }
 
+size_t Logger::nFields() const { return logs.size(); }
+
+std::string Logger::fieldName(size_t iL) const { return std::get<0>(logs[iL]); }
+
+void Logger::printField(std::ostream& out, size_t iL) const {
+  switch (std::get<1>(logs[iL])) {
+  case LogType::STRING:
+    out << stringLogs[std::get<2>(logs[iL])];
+    break;
+  case LogType::DOUBLE:
+    out << doubleLogs[std::get<2>(logs[iL])];
+    break;
+  }
+}
+
+long Logger::findField(std::string name) const {
+  long iL = -1;
+  auto itString = stringFields.find(name);
+  if (itString != stringFields.end()) iL = itString->second;
+  auto itDouble = doubleFields.find(name);
+  if (itDouble != doubleFields.end()) iL = std::max(iL, (long)itDouble->second);
+  return iL;
+}
+
 bool Logger::writeLog(std::string filename) const {
   std::ofstream out;
 
@@ -88,20 +125,211 @@ void Logger::writeLog(std::ostream& out) const {
   }
   out << std::get<0>(logs[logs.size() - 1]) << std::endl;
 
-  auto printLog = [&](size_t iL) {
-    switch (std::get<1>(logs[iL])) {
-    case LogType::STRING:
-      out << stringLogs[std::get<2>(logs[iL])];
-      break;
-    case LogType::DOUBLE:
-      out << doubleLogs[std::get<2>(logs[iL])];
-      break;
-    }
-  };
-
   for (size_t iL = 0; iL + 1 < N; ++iL) {
-    printLog(iL);
+    printField(out, iL);
     out << "\t";
   }
-  printLog(logs.size() - 1);
+  printField(out, logs.size() - 1);
+}
+
+TsvLogStream::TsvLogStream(std::string filename_) : filename(filename_), file(nullptr), haveSchema(false) {
+  // Adopt the columns of an existing file, so that runs can keep appending to it
+  std::ifstream existing(filename);
+  std::string header;
+  if (existing.is_open() && std::getline(existing, header) && !header.empty()) {
+    std::istringstream headerStream(header);
+    std::string column;
+    while (std::getline(headerStream, column, '\t')) columns.push_back(column);
+    columnSet.insert(columns.begin(), columns.end());
+    haveSchema = true;
+  }
+  existing.close();
+
+  file = std::fopen(filename.c_str(), "ab");
+  if (!file) {
+    throw std::runtime_error("failed to open log file " + filename);
+  }
+}
+
+TsvLogStream::~TsvLogStream() {
+  try {
+    close();
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+  }
+}
+
+void TsvLogStream::append(const Logger& logger, bool canDefineSchema) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!file) {
+    throw std::runtime_error("log file " + filename + " is already closed");
+  }
+
+  if (!haveSchema) {
+    if (!canDefineSchema) {
+      pendingRows.push_back(logger);
+      return;
+    }
+    setSchema({&logger});
+  }
+
+  writeRow(logger);
+  for (const Logger& pending : pendingRows) writeRow(pending);
+  pendingRows.clear();
+}
+
+void TsvLogStream::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!file) return;
+
+  if (!pendingRows.empty()) {
+    std::vector<const Logger*> loggers;
+    for (const Logger& pending : pendingRows) loggers.push_back(&pending);
+    if (!haveSchema) setSchema(loggers);
+    for (const Logger& pending : pendingRows) writeRow(pending);
+    pendingRows.clear();
+  }
+
+  std::fclose(file);
+  file = nullptr;
+}
+
+void TsvLogStream::setSchema(const std::vector<const Logger*>& loggers) {
+  std::unordered_map<std::string, bool> seen;
+  for (const Logger* logger : loggers) {
+    for (size_t iL = 0; iL < logger->nFields(); iL++) {
+      std::string name = logger->fieldName(iL);
+      if (seen[name]) continue;
+      seen[name] = true;
+      columns.push_back(name);
+    }
+  }
+  columnSet.insert(columns.begin(), columns.end());
+  haveSchema = true;
+
+  std::string header;
+  for (size_t iC = 0; iC < columns.size(); iC++) {
+    if (iC > 0) header += "\t";
+    header += columns[iC];
+  }
+  header += "\n";
+  std::fwrite(header.data(), 1, header.size(), file);
+}
+
+void TsvLogStream::writeRow(const Logger& logger) {
+  // Format the whole row first and write it with a single call, so that a crash can't leave half a row behind
+  std::ostringstream row;
+  for (size_t iC = 0; iC < columns.size(); iC++) {
+    if (iC > 0) row << "\t";
+    long iL = logger.findField(columns[iC]);
+    if (iL >= 0) logger.printField(row, iL);
+  }
+  row << "\n";
+
+  // The columns cannot grow once written, so say which fields a row loses, once for each field
+  for (size_t iL = 0; iL < logger.nFields(); iL++) {
+    std::string name = logger.fieldName(iL);
+    if (columnSet.count(name) || !warnedFields.insert(name).second) continue;
+    std::cerr << "Warning: " << filename << " has no '" << name << "' column, so it is left out of every row"
+              << std::endl;
+  }
+
+  std::string rowString = row.str();
+  bool ok = std::fwrite(rowString.data(), 1, rowString.size(), file) == rowString.size();
+  ok = ok && std::fflush(file) == 0;
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  if (!ok) {
+    throw std::runtime_error("failed to write to log file " + filename);
+  }
+}
+
+PhaseTimer::PhaseTimer() {}
+
+void PhaseTimer::setConcurrent(bool concurrent_) { concurrent = concurrent_; }
+
+bool PhaseTimer::isConcurrent() const { return concurrent; }
+
+double PhaseTimer::cpuNow() const {
+  if (concurrent) return threadCpuSeconds();
+  return std::clock() / (double)CLOCKS_PER_SEC;
+}
+
+void PhaseTimer::begin(std::string name) {
+  std::string path = runningPhases.empty() ? name : phases[runningPhases.back()].path + "/" + name;
+
+  size_t iP;
+  auto it = phaseIndex.find(path);
+  if (it == phaseIndex.end()) {
+    iP = phases.size();
+    phaseIndex[path] = iP;
+    phases.push_back(Phase{path, 0, 0, 0, 0, 0, std::chrono::steady_clock::time_point(), 0, 0, 0});
+  } else {
+    iP = it->second;
+  }
+
+  runningPhases.push_back(iP);
+  if (!concurrent) {
+    phases[iP].rssStart = currentResidentSetBytes();
+    phases[iP].peakStart = peakResidentSetBytes();
+  }
+  phases[iP].wallStart = std::chrono::steady_clock::now();
+  phases[iP].cpuStart = cpuNow();
+}
+
+double PhaseTimer::end() {
+  if (runningPhases.empty()) {
+    throw std::runtime_error("PhaseTimer::end() called with no running phase");
+  }
+  Phase& phase = phases[runningPhases.back()];
+  runningPhases.pop_back();
+
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - phase.wallStart).count();
+  double cpu = cpuNow() - phase.cpuStart;
+  phase.wallSeconds += wall;
+  phase.cpuSeconds += cpu;
+  if (!concurrent) {
+    phase.rssDeltaBytes += (double)currentResidentSetBytes() - (double)phase.rssStart;
+    phase.peakIncreaseBytes += (double)peakResidentSetBytes() - (double)phase.peakStart;
+  }
+  phase.nFinished++;
+  return wall;
+}
+
+PhaseTimer::Scope::Scope(PhaseTimer& timer_, std::string name) : timer(timer_), running(true) { timer.begin(name); }
+
+PhaseTimer::Scope::~Scope() {
+  if (running) timer.end();
+}
+
+double PhaseTimer::Scope::stop() {
+  if (!running) return 0;
+  running = false;
+  return timer.end();
+}
+
+double PhaseTimer::wallTime(std::string path) const {
+  auto it = phaseIndex.find(path);
+  if (it == phaseIndex.end() || phases[it->second].nFinished == 0) return -1;
+  return phases[it->second].wallSeconds;
+}
+
+double PhaseTimer::cpuTime(std::string path) const {
+  auto it = phaseIndex.find(path);
+  if (it == phaseIndex.end() || phases[it->second].nFinished == 0) return -1;
+  return phases[it->second].cpuSeconds;
+}
+
+void PhaseTimer::log(Logger& logger) const {
+  for (const Phase& phase : phases) {
+    if (phase.nFinished == 0) continue;
+    logger.log("time/" + phase.path + "/wall", phase.wallSeconds);
+    logger.log("time/" + phase.path + "/cpu", phase.cpuSeconds);
+    if (concurrent) continue;
+    logger.log("mem/" + phase.path + "/rssDeltaMB", phase.rssDeltaBytes / BYTES_PER_MB);
+    logger.log("mem/" + phase.path + "/peakIncreaseMB", phase.peakIncreaseBytes / BYTES_PER_MB);
+  }
 }
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <chrono>
+#include <cstdio>
+#include <ctime>
 #include <fstream>
 #include <iomanip> // setw
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 enum class LogType { STRING, DOUBLE };
@@ -23,6 +29,14 @@ public:
   bool writeLog(std::string filename) const;
   void writeLog(std::ostream& out) const;
 
+  // Fields in the order they were first logged
+  size_t nFields() const;
+  std::string fieldName(size_t iL) const;
+  void printField(std::ostream& out, size_t iL) const;
+
+  // Index of the most recently added field with this name, or -1 if there is none
+  long findField(std::string name) const;
+
 protected:
   void logString(std::string name, std::string val);
   void logDouble(std::string name, double val);
@@ -30,6 +44,115 @@ protected:
   std::vector<std::tuple<std::string, LogType, size_t>> logs;
   std::vector<std::string> stringLogs;
   std::vector<double> doubleLogs;
+
+  // Index in `logs` of each field, by name
+  std::unordered_map<std::string, size_t> stringFields;
+  std::unordered_map<std::string, size_t> doubleFields;
+};
+
+// Appends one row per Logger to a TSV file shared by many runs, without ever rewriting what is already there. The
+// columns are fixed once: by the header of the file if it already has one, or else by the first row appended. Fields
+// missing from a later row are left empty, and fields which are not in the schema are dropped. Each row is flushed and
+// synced to disk before append() returns, so a crash loses at most the row being written. Safe to use from several
+// threads at once.
+class TsvLogStream {
+public:
+  TsvLogStream(std::string filename);
+  ~TsvLogStream();
+
+  // Append a row. Rows which may be incomplete (e.g. from a run which failed) should pass canDefineSchema = false, so
+  // that they are held back until a complete row has fixed the columns; if none ever arrives, they are written when
+  // the stream closes, using every field any of them logged.
+  void append(const Logger& logger, bool canDefineSchema = true);
+
+  // Write any held back rows and close the file
+  void close();
+
+private:
+  TsvLogStream(const TsvLogStream&) = delete;
+  TsvLogStream& operator=(const TsvLogStream&) = delete;
+
+  void setSchema(const std::vector<const Logger*>& loggers);
+  void writeRow(const Logger& logger);
+
+  std::mutex mutex;
+  std::string filename;
+  std::FILE* file;
+  std::vector<std::string> columns;
+  std::unordered_set<std::string> columnSet;
+  std::unordered_set<std::string> warnedFields; // fields outside the columns, already reported as dropped
+  bool haveSchema;
+  std::vector<Logger> pendingRows;
+};
+
+// Records wall-clock time (from a steady clock), CPU time and memory usage for named phases of a computation. Phases
+// may nest, and are identified by their path: the names of all enclosing phases joined by '/'. Running the same phase
+// more than once accumulates its measurements. CPU time and memory are for the whole process, so they include any
+// worker threads, unless the timer is marked concurrent.
+class PhaseTimer {
+public:
+  PhaseTimer();
+
+  // Mark that other work shares the process while phases are timed, as when batch mode processes several meshes at
+  // once. CPU time is then measured for the thread which begins and ends each phase only, and memory is not measured
+  // at all, since the process-wide resident set sizes would include the other work. Set before any phase begins.
+  void setConcurrent(bool concurrent);
+  bool isConcurrent() const;
+
+  // Start a phase nested inside the innermost running phase
+  void begin(std::string name);
+
+  // Stop the innermost running phase, returning its wall time in seconds
+  double end();
+
+  // Times a phase for the lifetime of the object, unless it is stopped early
+  class Scope {
+  public:
+    Scope(PhaseTimer& timer, std::string name);
+    ~Scope();
+
+    // Stop the phase now, returning its wall time in seconds
+    double stop();
+
+  private:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    PhaseTimer& timer;
+    bool running;
+  };
+
+  // Total wall time and CPU time for a phase, or -1 if it never ran
+  double wallTime(std::string path) const;
+  double cpuTime(std::string path) const;
+
+  // Log the measurements of every phase which has finished in the order the phases first started, as the columns
+  //   - "time/<path>/wall" and "time/<path>/cpu": seconds spent in the phase
+  //   - "mem/<path>/rssDeltaMB": change in resident set size over the phase, unless concurrent
+  //   - "mem/<path>/peakIncreaseMB": how far the phase raised the process's peak resident set size, unless concurrent
+  void log(Logger& logger) const;
+
+private:
+  struct Phase {
+    std::string path;
+    double wallSeconds;
+    double cpuSeconds;
+    size_t nFinished;
+    double rssDeltaBytes;
+    double peakIncreaseBytes;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+    size_t rssStart;
+    size_t peakStart;
+  };
+
+  // CPU time so far, in seconds, from the clock setConcurrent() picked
+  double cpuNow() const;
+
+  bool concurrent = false;
+  std::vector<Phase> phases;
+  std::unordered_map<std::string, size_t> phaseIndex;
+  std::vector<size_t> runningPhases;
 };
 
 // explicit specializations
@@ -7,218 +7,565 @@
 #include "geometrycentral/surface/transfer_functions.h"
 #include "geometrycentral/surface/vertex_position_geometry.h"
 
+// Headless builds (the int_tri_cli target) leave out the GUI, and do not link polyscope or imgui
+#ifndef INT_TRI_HEADLESS
+#include "imgui.h"
+#include "polyscope/curve_network.h"
 #include "polyscope/point_cloud.h"
 #include "polyscope/polyscope.h"
 #include "polyscope/surface_mesh.h"
+#endif
 
 #include "args/args.hxx"
-#include "imgui.h"
+#include "async_writer.h"
+#include "attribute_sampling.h"
+#include "backend_selection.h"
+#include "compact_common_subdivision.h"
+#include "content_hash.h"
+#include "function_transfer.h"
+#include "intrinsic_outputs.h"
+#include "intrinsic_solvers.h"
+#include "laplacian_assembly.h"
 #include "logger.h"
-
+#include "matrix_io.h"
+#include "memory_usage.h"
+#include "mesh_loading.h"
+#include "parallel.h"
+#include "parallel_delaunay.h"
+#include "regional_common_subdivision.h"
+#include "subdivision_view.h"
+#include "triangulation_pipeline.h"
+#include "work_stealing_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 using namespace geometrycentral;
 using namespace geometrycentral::surface;
 
-// == Geometry-central data
-std::unique_ptr<ManifoldSurfaceMesh> mesh;
-std::unique_ptr<VertexPositionGeometry> geometry;
-std::unique_ptr<IntrinsicTriangulation> intTri;
+// All of the state for processing one mesh. The GUI works on a single global context, while batch runs create one
+// context per job so that several meshes can be processed at once.
+struct MeshContext {
+  // The input mesh and its intrinsic triangulation, with the stages run on them. The pipeline also holds the limits
+  // on flips and refinement (its time budgets), its thread count, and a triangulation loaded with
+  // --loadTriangulation, whose outputs are written instead.
+  TriangulationPipeline pipeline;
+
+  // Parameters
+  std::string backend = "Integer Coordinates";
+  float refineToSize = -1;
+  float refineDegreeThresh = 25;
+  bool useRefineSizeThresh = false;
+  bool useInsertionsMax = false;
+  int insertionsMax = -2;
+  int traceThreads = -1; // if non-negative, trace edges on this many threads (0 = one per hardware thread)
+
+  // How the last flips and refinement ended: "complete", "timeBudget" or "interrupted"
+  std::string flipStatus;
+  std::string refineStatus;
+
+  // Output options
+  std::string outputPrefix;
+  MatrixFormat outputFormat = MatrixFormat::ASCII;
+  bool transferToIntrinsic = true; // directions written by --functionTransferMat and --transferFunction
+  bool transferToInput = true;
+  std::string transferFunction; // file of functions to transfer with --transferFunction, if not empty
+  std::string sampleAttributes; // file of input vertex attributes to sample with --sampleAttributes, if not empty
+  std::string heatGeodesic;     // file of source vertex sets for --heatGeodesic, if not empty
+  std::string poissonSolve;     // file of right-hand sides for --poissonSolve, if not empty
+
+  // Print progress messages. Disabled when jobs run concurrently so that their output does not interleave.
+  bool verbose = true;
+
+  // Wall and CPU time spent in each phase of processing this mesh
+  PhaseTimer timer;
+
+  // If set, statistics are appended to this shared file as one row, rather than written to <outputPrefix>stats.tsv
+  TsvLogStream* statsStream = nullptr;
+
+  // If set, output files are written by this writer's I/O thread rather than by the thread producing them
+  std::unique_ptr<AsyncFileWriter> writer;
+
+  // The vertices and edges of the common subdivision, traced with --compactCommonSubdivision. Cleared by any edit.
+  std::unique_ptr<CompactCommonSubdivision> compactCS;
+
+  // The traced edges of the common subdivision over the region given by --commonSubdivisionRegion, or over the whole
+  // mesh once shown in the GUI. Kept up to date across edits to the triangulation, but replaced along with it.
+  std::unique_ptr<RegionalCommonSubdivision> regionalCS;
+
+  // If set, the content hash of every output file is recorded in outputHashes, in the order the files are written
+  bool hashOutputs = false;
+  std::vector<std::pair<std::string, uint64_t>> outputHashes;
+};
+
+// The mesh shown in the GUI (and processed in single-mesh mode)
+MeshContext guiContext;
 
-// Polyscope visualization handle, to quickly add data to the surface
 bool withGUI = true;
+
+#ifndef INT_TRI_HEADLESS
+// Polyscope visualization handle, to quickly add data to the surface
 polyscope::SurfaceMesh* psMesh;
 
-// Parameters
-std::string backend = "Integer Coordinates";
-float refineToSize = -1;
-float refineDegreeThresh = 25;
-bool useRefineSizeThresh = false;
-bool useInsertionsMax;
-int insertionsMax = -2;
+// Whether to re-trace and show the changed intrinsic edges after every flip or refinement in the GUI
+bool updateTracedEdgesAfterEdits = false;
+
+// Level of detail: larger common subdivisions are shown by their intrinsic edges, and traced edges are thinned out to
+// this many nodes. Both are kept well below what fits in GPU memory, so that the viewer stays interactive.
+int maxShownSubdivisionFaces = 2000000;
+int maxShownEdgeNodes = 1000000;
 
 // Mesh stats
 bool intTriIsDelaunay = true;
 float intTriMinValidAngleDeg = 0.;
+#endif
 
-// Output options
-std::string outputPrefix;
-
-void resetTriangulation() {
-  if (backend == "Integer Coordinates") {
-    intTri.reset(new IntegerCoordinatesIntrinsicTriangulation(*mesh, *geometry));
-  } else if (backend == "Signposts") {
-    intTri.reset(new SignpostIntrinsicTriangulation(*mesh, *geometry));
-  } else {
-    throw std::runtime_error("unrecognized backed");
+void warning(const MeshContext& ctx, std::string msg) {
+#ifndef INT_TRI_HEADLESS
+  if (withGUI) {
+    polyscope::warning(msg);
+    return;
+  }
+#endif
+  if (ctx.verbose) {
+    std::cout << "Warning: " << msg << std::endl;
   }
 }
 
-void flipDelaunayTriangulation() {
-  std::cout << "Flipping triangulation to Delaunay" << std::endl;
-  intTri->flipToDelaunay();
+// Set by a SIGINT which arrives while flips or refinement are running in rounds. They then stop at the end of their
+// current round, and processing carries on from the triangulation so far.
+std::atomic<bool> interrupted(false);
+std::atomic<int> nInterruptibleStages(0);
 
-  if (!intTri->isDelaunay()) {
-    polyscope::warning("Failed to make mesh Delaunay with flips");
+// Marks a stage which stops cleanly once interrupted is set, for the lifetime of the object, if active
+struct InterruptibleStage {
+  explicit InterruptibleStage(bool active = true) : active(active) {
+    if (active) nInterruptibleStages++;
+  }
+  ~InterruptibleStage() {
+    if (active) nInterruptibleStages--;
+  }
+  bool active;
+};
+
+// A SIGINT during an interruptible stage sets interrupted, and otherwise ends the process as usual. Only the first is
+// caught, so a second one always ends the process.
+extern "C" void handleInterrupt(int signal) {
+  std::signal(signal, SIG_DFL);
+  if (nInterruptibleStages.load() > 0) {
+    interrupted.store(true);
+  } else {
+    std::raise(signal);
   }
-  std::cout << "\t...done" << std::endl;
 }
 
-void refineDelaunayTriangulation() {
-  // Manage optional parameters
-  double sizeParam = useRefineSizeThresh ? refineToSize : std::numeric_limits<double>::infinity();
-  size_t maxInsertions = useInsertionsMax ? insertionsMax : INVALID_IND;
+// For --progress: report the number of changes (flips or insertions) made by flips or refinement in rounds, at most
+// once a second
+std::function<void(const std::string&, size_t, size_t, double)> progressReporter() {
+  typedef std::chrono::steady_clock::time_point TimePoint;
+  std::shared_ptr<TimePoint> lastReport(new TimePoint(std::chrono::steady_clock::now()));
+  return [=](const std::string& changes, size_t nRounds, size_t nChanges, double seconds) {
+    TimePoint now = std::chrono::steady_clock::now();
+    if (now - *lastReport < std::chrono::seconds(1)) return;
+    *lastReport = now;
+    std::cout << "\t" << nChanges << " " << changes << " in " << nRounds << " rounds so far (" << seconds << "s)"
+              << std::endl;
+  };
+}
 
-  std::cout << "Refining triangulation to Delaunay with:   degreeThresh=" << refineDegreeThresh
-            << " circumradiusThresh=" << refineToSize << " maxInsertions=" << maxInsertions << std::endl;
+void resetTriangulation(MeshContext& ctx) {
+  ctx.compactCS.reset();
+  ctx.regionalCS.reset();
+  ctx.pipeline.resetTriangulation(ctx.backend);
+}
 
-  intTri->delaunayRefine(refineDegreeThresh, sizeParam, maxInsertions);
+void flipDelaunayTriangulation(MeshContext& ctx) {
+  if (ctx.verbose) std::cout << "Flipping triangulation to Delaunay" << std::endl;
+  ctx.compactCS.reset();
+  {
+    // Only rounds can stop partway
+    InterruptibleStage stage(ctx.pipeline.flipsInRounds());
+    FlipRoundStats stats = ctx.pipeline.flipToDelaunay();
+    if (ctx.verbose && ctx.pipeline.flipsInRounds()) {
+      std::cout << "\t" << stats.nFlips << " flips in " << stats.nRounds << " rounds" << std::endl;
+    }
+  }
+  ctx.flipStatus = ctx.pipeline.flipStatus();
 
-  if (!intTri->isDelaunay()) {
-    polyscope::warning("Failed to make mesh Delaunay with flips & refinement.");
+  if (ctx.flipStatus != "complete") {
+    warning(ctx, "Stopped flipping early (" + ctx.flipStatus + "), continuing from the triangulation so far");
+  } else if (!ctx.pipeline.intrinsicTriangulation().isDelaunay()) {
+    warning(ctx, "Failed to make mesh Delaunay with flips");
   }
-  std::cout << "\t...done" << std::endl;
+  if (ctx.verbose) std::cout << "\t...done" << std::endl;
 }
 
-void computeCommonSubdivision() {
-  std::cout << "Computing common subdivision" << std::endl;
-  CommonSubdivision& cs = intTri->getCommonSubdivision();
-  cs.constructMesh();
-  if (withGUI) {
-    VertexData<Vector3> subdivisionPositions = cs.interpolateAcrossA(geometry->vertexPositions);
-    polyscope::SurfaceMesh* psSub =
-        polyscope::registerSurfaceMesh("common subdivision", subdivisionPositions, cs.mesh->getFaceVertexList());
+void refineDelaunayTriangulation(MeshContext& ctx) {
+  // Manage optional parameters
+  double sizeParam = ctx.useRefineSizeThresh ? ctx.refineToSize : std::numeric_limits<double>::infinity();
+  size_t maxInsertions = ctx.useInsertionsMax ? ctx.insertionsMax : INVALID_IND;
 
-    // colors from intrinsic mesh
-    FaceData<double> colorsIntrinsic = cs.copyFromB(niceColors(cs.meshB));
-    psSub->addFaceScalarQuantity("coloring, intrinsic", colorsIntrinsic)->setColorMap("spectral")->setEnabled(true);
+  if (ctx.verbose) {
+    std::cout << "Refining triangulation to Delaunay with:   degreeThresh=" << ctx.refineDegreeThresh
+              << " circumradiusThresh=" << ctx.refineToSize << " maxInsertions=" << maxInsertions << std::endl;
+  }
+  ctx.compactCS.reset();
+  {
+    InterruptibleStage stage(ctx.pipeline.refinesInRounds());
+    RefineRoundStats stats = ctx.pipeline.refineDelaunay(ctx.refineDegreeThresh, sizeParam, maxInsertions);
+    if (ctx.verbose && ctx.pipeline.refinesInRounds()) {
+      std::cout << "\t" << stats.nInsertions << " insertions in " << stats.nRounds << " rounds" << std::endl;
+    }
+  }
+  ctx.refineStatus = ctx.pipeline.refineStatus();
 
-    // colors from input mesh
-    FaceData<double> colorsInput = cs.copyFromA(niceColors(cs.meshA));
-    psSub->addFaceScalarQuantity("coloring, input", colorsInput)->setColorMap("spectral");
+  if (ctx.refineStatus != "complete") {
+    warning(ctx, "Stopped refining early (" + ctx.refineStatus + "), continuing from the triangulation so far");
+  } else if (!ctx.pipeline.intrinsicTriangulation().isDelaunay()) {
+    warning(ctx, "Failed to make mesh Delaunay with flips & refinement.");
   }
-  std::cout << "\t...done" << std::endl;
+  if (ctx.verbose) std::cout << "\t...done" << std::endl;
 }
 
-template <typename T>
-void outputMatrix(std::string filename, SparseMatrix<T>& matrix) {
-  std::cout << "Writing sparse matrix to: " << filename << std::endl;
-  saveSparseMatrix(outputPrefix + filename, matrix);
+// Trace the intrinsic edges along the input mesh. The triangulation caches the result until it is next modified, so
+// only the first call does any work.
+CommonSubdivision& traceCommonSubdivision(MeshContext& ctx) {
+  return ctx.pipeline.intrinsicTriangulation().getCommonSubdivision();
 }
 
-template <typename T>
-void outputMatrix(std::string filename, DenseMatrix<T>& matrix) {
-  std::cout << "Writing dense matrix to: " << filename << std::endl;
-  saveDenseMatrix(outputPrefix + filename, matrix);
+// Build the explicit mesh of the common subdivision, unless it has already been built
+CommonSubdivision& meshCommonSubdivision(MeshContext& ctx) {
+  CommonSubdivision& cs = traceCommonSubdivision(ctx);
+  if (!cs.mesh) cs.constructMesh();
+  return cs;
 }
 
-void outputIntrinsicFaces() {
-
-  intTri->requireVertexIndices();
-
-  // Assemble Fx3 adjacency matrices vertex indices and edge lengths
-  size_t nV = intTri->mesh.nVertices();
-  size_t nF = intTri->mesh.nFaces();
-
-  DenseMatrix<double> faceLengths(nF, 3);
-  DenseMatrix<size_t> faceInds(nF, 3);
+#ifndef INT_TRI_HEADLESS
+// The face colors of the common subdivision last shown, one byte per face, so that switching between the coloring
+// quantities uploads one of these instead of recomputing it
+struct SubdivisionColors {
+  std::vector<uint8_t> intrinsic, input;
+  bool showInput = false;
+};
+SubdivisionColors subdivisionColors;
+
+// Register the coloring of the common subdivision selected by subdivisionColors.showInput, as its only quantity.
+// Polyscope keeps a copy of every registered quantity on the CPU and the GPU, as doubles, so only one is kept.
+void showSubdivisionColoring() {
+  if (!polyscope::hasSurfaceMesh("common subdivision")) return;
+  polyscope::SurfaceMesh* psSub = polyscope::getSurfaceMesh("common subdivision");
+  bool input = subdivisionColors.showInput;
+  psSub->removeQuantity(input ? "coloring, intrinsic" : "coloring, input");
+  const std::vector<uint8_t>& colors = input ? subdivisionColors.input : subdivisionColors.intrinsic;
+  psSub->addFaceScalarQuantity(input ? "coloring, input" : "coloring, intrinsic", colors)
+      ->setColorMap("spectral")
+      ->setEnabled(true);
+}
 
-  size_t iF = 0;
-  for (Face f : intTri->mesh.faces()) {
+// Whether the common subdivision is small enough to show as a mesh, counted from its traced points so that no mesh
+// need be built to tell
+bool showsSubdivisionMesh(const CommonSubdivision& cs) {
+  return cs.nFacesTriangulation() <= static_cast<size_t>(std::max(maxShownSubdivisionFaces, 0));
+}
 
-    Halfedge he = f.halfedge();
-    for (int v = 0; v < 3; v++) {
+// Show the common subdivision. Above maxShownSubdivisionFaces faces, unless fullResolution is set, show only its
+// intrinsic edges instead, thinned out to maxShownEdgeNodes nodes; its mesh would take more memory on the GPU than the
+// input and intrinsic meshes together, so it is then not built at all.
+void showCommonSubdivision(MeshContext& ctx, bool fullResolution = false) {
+  CommonSubdivision& cs = traceCommonSubdivision(ctx);
+  const std::string edgesName = "common subdivision edges";
+
+  if (!fullResolution && !showsSubdivisionMesh(cs)) {
+    polyscope::removeSurfaceMesh("common subdivision", false);
+    CurveBuffers edges = decimatePolylines(intrinsicEdgePolylines(cs, ctx.pipeline.inputGeometry().vertexPositions),
+                                           static_cast<size_t>(std::max(maxShownEdgeNodes, 0)));
+    polyscope::CurveNetwork* psEdges = polyscope::registerCurveNetwork(edgesName, edges.nodes, edges.segments);
+    psEdges->setRadius(0.0005);
+    if (ctx.verbose) {
+      std::cout << "Common subdivision has " << cs.nFacesTriangulation() << " faces, showing its intrinsic edges with "
+                << edges.nodes.size() << " nodes instead" << std::endl;
+    }
+    return;
+  }
 
-      Vertex vA = he.vertex();
-      Vertex vB = he.twin().vertex();
-      size_t indA = intTri->vertexIndices[vA];
-      size_t indB = intTri->vertexIndices[vB];
-      Edge e = he.edge();
-      double l = intTri->edgeLengths[e];
+  polyscope::removeCurveNetwork(edgesName, false);
+  meshCommonSubdivision(ctx);
+  VertexData<Vector3> subdivisionPositions = cs.interpolateAcrossA(ctx.pipeline.inputGeometry().vertexPositions);
+  polyscope::registerSurfaceMesh("common subdivision", subdivisionPositions, triangleIndices(*cs.mesh));
 
-      faceLengths(iF, v) = l;
-      faceInds(iF, v) = indA;
+  // colors from the intrinsic and input meshes
+  subdivisionColors.intrinsic = subdivisionFaceColors(cs, false);
+  subdivisionColors.input = subdivisionFaceColors(cs, true);
+  showSubdivisionColoring();
+}
 
-      he = he.next();
-    }
+// Show the intrinsic edges traced over the input mesh, tracing only the edges changed since they were last shown.
+// Unlike the common subdivision, which geometry-central rebuilds from scratch after any edit, this costs time in
+// proportion to the size of the edit.
+void showTracedEdges(MeshContext& ctx) {
+  const std::string name = "traced intrinsic edges";
+  if (!ctx.regionalCS) {
+    ctx.regionalCS.reset(new RegionalCommonSubdivision(ctx.pipeline.intrinsicTriangulation()));
+    ctx.regionalCS->addAllFaces();
+  }
+  size_t nTraced = ctx.regionalCS->update(ctx.traceThreads >= 0 ? ctx.traceThreads : 1);
+  if (ctx.verbose) std::cout << "Traced " << nTraced << " new or changed intrinsic edges" << std::endl;
+  if (nTraced == 0 && polyscope::hasCurveNetwork(name)) return;
+
+  // Polyscope cannot resize a structure's buffers in place, so the curve network is registered again. That only
+  // uploads the cached paths; none are traced again.
+  CurveBuffers edges = decimatePolylines(ctx.regionalCS->polylines(ctx.pipeline.inputGeometry()),
+                                         static_cast<size_t>(std::max(maxShownEdgeNodes, 0)));
+  polyscope::CurveNetwork* psEdges = polyscope::registerCurveNetwork(name, edges.nodes, edges.segments);
+  psEdges->setRadius(0.0005);
+}
 
-    iF++;
+void computeCommonSubdivision(MeshContext& ctx) {
+  if (ctx.verbose) std::cout << "Computing common subdivision" << std::endl;
+  showCommonSubdivision(ctx);
+  if (ctx.verbose) std::cout << "\t...done" << std::endl;
+}
+#endif
+
+// Write a file through the context's asynchronous writer, or directly if it has none
+void outputFile(MeshContext& ctx, std::string filename, std::string contents) {
+  if (ctx.hashOutputs) ctx.outputHashes.emplace_back(filename, fnv1aHash(contents));
+  std::string path = ctx.outputPrefix + filename;
+  if (ctx.writer) {
+    ctx.writer->write(path, std::move(contents));
+  } else {
+    AsyncFileWriter::writeFile(path, contents);
   }
+}
 
-  outputMatrix("faceInds.dmat", faceInds);
-  outputMatrix("faceLengths.dmat", faceLengths);
+template <typename T, int Options>
+std::string encodeMatrix(MatrixFormat format, const Eigen::SparseMatrix<T, Options>& matrix) {
+  return encodeSparseMatrix(format, matrix);
 }
 
-void outputVertexPositions() {
-  intTri->requireVertexIndices();
+template <typename T>
+std::string encodeMatrix(MatrixFormat format, const DenseMatrix<T>& matrix) {
+  return encodeDenseMatrix(format, matrix);
+}
 
-  size_t nV = intTri->mesh.nVertices();
-  DenseMatrix<double> vertexPositions(nV, 3);
+// Encode a matrix on this thread, then hand it to outputFile()
+template <typename M>
+void outputMatrix(MeshContext& ctx, std::string filename, const M& matrix) {
+  filename += matrixFormatSuffix(ctx.outputFormat);
+  PhaseTimer::Scope phase(ctx.timer, filename);
+  if (ctx.verbose) std::cout << "Writing matrix to: " << filename << std::endl;
+  outputFile(ctx, filename, encodeMatrix(ctx.outputFormat, matrix));
+}
 
-  VertexData<Vector3> intrinsicPositions = intTri->sampleFromInput(geometry->inputVertexPositions);
+// Assemble every requested intrinsic output together, then encode each buffer and pass it on to be written
+void outputIntrinsicTriangulation(MeshContext& ctx, const IntrinsicOutputs& request) {
+  PhaseTimer::Scope assemblePhase(ctx.timer, "assemble");
+  if (request.laplaceMat || request.massMat) {
+    size_t nRows = ctx.pipeline.laplacianAssembler().update(ctx.pipeline.nThreads);
+    if (ctx.verbose) std::cout << "Assembled " << nRows << " new or changed Laplacian rows" << std::endl;
+  }
+  const IntrinsicOutputBuffers& buffers = ctx.pipeline.assemble(request);
+  assemblePhase.stop();
 
-  size_t iV = 0;
-  for (Vertex v : intTri->mesh.vertices()) {
-    Vector3 p = intrinsicPositions[v];
-    vertexPositions(iV, 0) = p.x;
-    vertexPositions(iV, 1) = p.y;
-    vertexPositions(iV, 2) = p.z;
-    iV++;
+  if (request.intrinsicFaces) {
+    outputMatrix(ctx, "faceInds.dmat", buffers.faceInds);
+    outputMatrix(ctx, "faceLengths.dmat", buffers.faceLengths);
   }
+  if (request.vertexPositions) outputMatrix(ctx, "vertexPositions.dmat", buffers.vertexPositions);
+  // Written column-major, as geometry-central's matrices are
+  if (request.laplaceMat) outputMatrix(ctx, "laplace.spmat", SparseMatrix<double>(ctx.pipeline.laplacian()));
+  if (request.massMat) outputMatrix(ctx, "mass.spmat", SparseMatrix<double>(ctx.pipeline.lumpedMass()));
+  if (request.interpolateMat) outputMatrix(ctx, "interpolate.spmat", buffers.interpolate);
+}
 
-  outputMatrix("vertexPositions.dmat", vertexPositions);
+void outputIntrinsicFaces(MeshContext& ctx) {
+  IntrinsicOutputs request;
+  request.intrinsicFaces = true;
+  outputIntrinsicTriangulation(ctx, request);
 }
 
-void outputLaplaceMat() {
-  intTri->requireCotanLaplacian();
-  outputMatrix("laplace.spmat", intTri->cotanLaplacian);
+void outputVertexPositions(MeshContext& ctx) {
+  IntrinsicOutputs request;
+  request.vertexPositions = true;
+  outputIntrinsicTriangulation(ctx, request);
 }
 
-void outputInterpolatMat() {
-  intTri->requireVertexIndices();
+void outputLaplaceMat(MeshContext& ctx) {
+  IntrinsicOutputs request;
+  request.laplaceMat = true;
+  outputIntrinsicTriangulation(ctx, request);
+}
 
-  // Assemble Fx3 adjacency matrices vertex indices and edge lengths
-  size_t nV = intTri->mesh.nVertices();
+void outputMassMat(MeshContext& ctx) {
+  IntrinsicOutputs request;
+  request.massMat = true;
+  outputIntrinsicTriangulation(ctx, request);
+}
 
-  SparseMatrix<double> interpMat(nV, nV);
-  std::vector<Eigen::Triplet<double>> triplets;
+void outputInterpolatMat(MeshContext& ctx) {
+  IntrinsicOutputs request;
+  request.interpolateMat = true;
+  outputIntrinsicTriangulation(ctx, request);
+}
 
-  size_t iV = 0;
-  for (Vertex v : intTri->mesh.vertices()) {
-    SurfacePoint p = intTri->vertexLocations[v];
-    p = p.inSomeFace();
+void outputFunctionTransferMat(MeshContext& ctx) {
+  AttributeTransfer transfer(meshCommonSubdivision(ctx), ctx.pipeline.inputGeometry());
+  SparseMatrix<double> lhs, rhs;
+  if (ctx.transferToIntrinsic) {
+    std::tie(lhs, rhs) = transfer.constructAtoBMatrices();
+    outputMatrix(ctx, "InputToIntrinsic_lhs.spmat", lhs);
+    outputMatrix(ctx, "InputToIntrinsic_rhs.spmat", rhs);
+  }
+  if (ctx.transferToInput) {
+    std::tie(lhs, rhs) = transfer.constructBtoAMatrices();
+    outputMatrix(ctx, "IntrinsicToInput_lhs.spmat", lhs);
+    outputMatrix(ctx, "IntrinsicToInput_rhs.spmat", rhs);
+  }
+}
 
-    Face f = p.face;
+// Sample the input vertex attributes in ctx.sampleAttributes (one row per input vertex, one column per channel) at
+// every intrinsic vertex, all channels in one pass
+void outputSampledAttributes(MeshContext& ctx) {
+  AttributeMatrix attributes;
+  {
+    PhaseTimer::Scope phase(ctx.timer, "read");
+    attributes = loadDenseMatrix(ctx.sampleAttributes);
+  }
+  size_t nInputVertices = ctx.pipeline.nInputVertices();
+  if ((size_t)attributes.rows() != nInputVertices) {
+    throw std::runtime_error("cannot sample attributes with " + std::to_string(attributes.rows()) +
+                             " rows on an input mesh with " + std::to_string(nInputVertices) + " vertices");
+  }
 
-    int j = 0;
-    for (Vertex n : f.adjacentVertices()) {
-      size_t jV = intTri->vertexIndices[n];
-      double w = p.faceCoords[j];
-      if (w > 0) {
-        triplets.emplace_back(iV, jV, w);
+  IntrinsicView view = ctx.pipeline.intrinsicView();
+  std::vector<SurfacePoint> locations;
+  locations.reserve(view.mesh.nVertices());
+  for (Vertex v : view.mesh.vertices()) locations.push_back(view.vertexLocations[v]);
+
+  if (ctx.verbose) std::cout << "Sampling " << attributes.cols() << " attribute channels" << std::endl;
+  PhaseTimer::Scope samplePhase(ctx.timer, "sample");
+  DenseMatrix<double> sampled = sampleAttributes(locations, attributes, ctx.pipeline.nThreads);
+  samplePhase.stop();
+  outputMatrix(ctx, "sampledAttributes.dmat", sampled);
+}
+
+// Read lists of element indices, one list per line, separated by whitespace. Blank lines and lines starting with '#'
+// are skipped. Throws if the file cannot be read or an index is not below nElements.
+std::vector<std::vector<size_t>> readIndexLists(std::string filename, size_t nElements, std::string elementName,
+                                               std::string pluralName) {
+  std::ifstream in(filename);
+  if (!in.is_open()) throw std::runtime_error("failed to open " + elementName + " list " + filename);
+
+  std::vector<std::vector<size_t>> lists;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line[0] == '#') continue;
+    std::istringstream ss(line);
+    std::string token;
+    std::vector<size_t> list;
+    while (ss >> token) {
+      char* end;
+      unsigned long long index = std::strtoull(token.c_str(), &end, 10);
+      if (*end != '\0' || token[0] == '-') {
+        throw std::runtime_error("invalid " + elementName + " index '" + token + "' in " + filename);
+      }
+      if (index >= nElements) {
+        throw std::runtime_error(elementName + " index " + token + " in " + filename +
+                                 " is out of range for a mesh with " + std::to_string(nElements) + " " + pluralName);
       }
-      j++;
+      list.push_back(index);
     }
-    iV++;
+    if (!list.empty()) lists.push_back(list);
   }
+  return lists;
+}
 
-  interpMat.setFromTriplets(triplets.begin(), triplets.end());
-  interpMat.makeCompressed();
+// Read a list of face indices, separated by whitespace, over any number of lines
+std::vector<size_t> readFaceIndices(std::string filename, size_t nFaces) {
+  std::vector<size_t> faces;
+  for (const std::vector<size_t>& list : readIndexLists(filename, nFaces, "face", "faces")) {
+    faces.insert(faces.end(), list.begin(), list.end());
+  }
+  return faces;
+}
+
+// Geodesic distance by the heat method from each line of input vertex indices in ctx.heatGeodesic, as one column per
+// line over the intrinsic vertices
+void outputHeatGeodesic(MeshContext& ctx) {
+  std::vector<std::vector<size_t>> sourceLists =
+      readIndexLists(ctx.heatGeodesic, ctx.pipeline.inputMesh().nVertices(), "vertex", "vertices");
+
+  // Every input vertex is also an intrinsic vertex
+  IntrinsicView view = ctx.pipeline.intrinsicView();
+  std::vector<Vertex> intrinsicVertexOf(ctx.pipeline.inputMesh().nVertices());
+  for (Vertex v : view.mesh.vertices()) {
+    const SurfacePoint& p = view.vertexLocations[v];
+    if (p.type == SurfacePointType::Vertex) intrinsicVertexOf[p.vertex.getIndex()] = v;
+  }
+  std::vector<std::vector<Vertex>> sourceSets;
+  for (const std::vector<size_t>& list : sourceLists) {
+    sourceSets.emplace_back();
+    for (size_t iV : list) sourceSets.back().push_back(intrinsicVertexOf[iV]);
+  }
 
-  outputMatrix("interpolate.spmat", interpMat);
+  if (ctx.verbose) std::cout << "Computing geodesic distance from " << sourceSets.size() << " source sets" << std::endl;
+  PhaseTimer::Scope phase(ctx.timer, "solve");
+  DenseMatrix<double> distances = heatGeodesicDistances(view.geometry, sourceSets);
+  phase.stop();
+  outputMatrix(ctx, "heatGeodesic.dmat", distances);
 }
 
-void outputFunctionTransferMat() {
-  AttributeTransfer transfer(intTri->getCommonSubdivision(), *geometry);
-  SparseMatrix<double> AtoB_lhs, AtoB_rhs, BtoA_lhs, BtoA_rhs;
-  std::tie(AtoB_lhs, AtoB_rhs) = transfer.constructAtoBMatrices();
-  std::tie(BtoA_lhs, BtoA_rhs) = transfer.constructBtoAMatrices();
+// Solve the Poisson equation on the intrinsic triangulation for each column of ctx.poissonSolve, factoring the
+// Laplacian once for all of them
+void outputPoissonSolution(MeshContext& ctx) {
+  DenseMatrix<double> rhs;
+  {
+    PhaseTimer::Scope phase(ctx.timer, "read");
+    rhs = loadDenseMatrix(ctx.poissonSolve);
+  }
 
-  outputMatrix("InputToIntrinsic_lhs.spmat", AtoB_lhs);
-  outputMatrix("InputToIntrinsic_rhs.spmat", AtoB_rhs);
+  PhaseTimer::Scope factorPhase(ctx.timer, "factor");
+  LaplacianAssembler& assembler = ctx.pipeline.laplacianAssembler();
+  assembler.update(ctx.pipeline.nThreads);
+  PoissonSolver solver(assembler.laplacian(), assembler.lumpedMass());
+  factorPhase.stop();
+
+  if (ctx.verbose) std::cout << "Solving for " << rhs.cols() << " right-hand sides" << std::endl;
+  PhaseTimer::Scope solvePhase(ctx.timer, "solve");
+  DenseMatrix<double> solution = solver.solve(rhs);
+  solvePhase.stop();
+  outputMatrix(ctx, "poissonSolution.dmat", solution);
+}
+
+// Transfer the functions in ctx.transferFunction (one per column, one row per source vertex) in the requested
+// direction, factoring the target's mass matrix once for all of them
+void outputTransferredFunctions(MeshContext& ctx) {
+  DenseMatrix<double> fields;
+  {
+    PhaseTimer::Scope phase(ctx.timer, "read");
+    fields = loadDenseMatrix(ctx.transferFunction);
+  }
 
-  outputMatrix("IntrinsicToInput_lhs.spmat", BtoA_lhs);
-  outputMatrix("IntrinsicToInput_rhs.spmat", BtoA_rhs);
+  TransferDirection direction =
+      ctx.transferToIntrinsic ? TransferDirection::InputToIntrinsic : TransferDirection::IntrinsicToInput;
+  PhaseTimer::Scope factorPhase(ctx.timer, "factor");
+  FunctionTransfer transfer(meshCommonSubdivision(ctx), ctx.pipeline.inputGeometry(), direction);
+  factorPhase.stop();
+
+  if (ctx.verbose) std::cout << "Transferring " << fields.cols() << " functions" << std::endl;
+  PhaseTimer::Scope transferPhase(ctx.timer, "transfer");
+  DenseMatrix<double> transferred = transfer.transfer(fields, ctx.pipeline.nThreads);
+  transferPhase.stop();
+
+  std::string name = ctx.transferToIntrinsic ? "InputToIntrinsic_transferred.dmat" : "IntrinsicToInput_transferred.dmat";
+  outputMatrix(ctx, name, transferred);
 }
 
 void writeLog(const Logger& logger, std::string outputPrefix) {
@@ -229,28 +576,45 @@ void writeLog(const Logger& logger, std::string outputPrefix) {
   }
 }
 
-void outputCommonSubdivision() {
-  CommonSubdivision& cs = intTri->getCommonSubdivision();
-  if (!cs.mesh) cs.constructMesh();
-  VertexPositionGeometry csGeo(*cs.mesh, cs.interpolateAcrossA(geometry->vertexPositions));
+void outputCommonSubdivision(MeshContext& ctx) {
+  // Without a mesh, only the edges can be written, as polylines, which go in a file of their own so that
+  // common_subdivision.obj always holds faces
+  if (ctx.compactCS) {
+    PhaseTimer::Scope phase(ctx.timer, "common_subdivision_edges.obj");
+    if (ctx.verbose) std::cout << "Writing obj: " << ctx.outputPrefix << "common_subdivision_edges.obj" << std::endl;
+    outputFile(ctx, "common_subdivision_edges.obj", ctx.compactCS->encodeObj(ctx.pipeline.inputGeometry()));
+    return;
+  }
+
+  CommonSubdivision& cs = meshCommonSubdivision(ctx);
+  VertexPositionGeometry csGeo(*cs.mesh, cs.interpolateAcrossA(ctx.pipeline.inputGeometry().vertexPositions));
 
-  std::string filename = outputPrefix + "common_subdivision.obj";
-  std::cout << "Writing obj: " << filename << std::endl;
-  writeSurfaceMesh(*cs.mesh, csGeo, filename);
+  PhaseTimer::Scope phase(ctx.timer, "common_subdivision.obj");
+  if (ctx.verbose) std::cout << "Writing obj: " << ctx.outputPrefix << "common_subdivision.obj" << std::endl;
+  std::ostringstream obj;
+  writeSurfaceMesh(*cs.mesh, csGeo, obj, "obj");
+  outputFile(ctx, "common_subdivision.obj", obj.str());
 }
 
+void outputCommonSubdivisionRegion(MeshContext& ctx) {
+  if (ctx.verbose) std::cout << "Writing obj: " << ctx.outputPrefix << "common_subdivision_region.obj" << std::endl;
+  outputFile(ctx, "common_subdivision_region.obj", ctx.regionalCS->encodeObj(ctx.pipeline.inputGeometry()));
+}
+
+#ifndef INT_TRI_HEADLESS
 void myCallback() {
+  MeshContext& ctx = guiContext;
 
   ImGui::PushItemWidth(100);
 
   const std::array<std::string, 2> items = {"Integer Coordinates", "Signposts"};
-  if (ImGui::BeginCombo("##backendcombo", backend.c_str())) {
+  if (ImGui::BeginCombo("##backendcombo", ctx.backend.c_str())) {
     for (size_t n = 0; n < items.size(); n++) {
-      bool is_selected = (backend == items[n]);
+      bool is_selected = (ctx.backend == items[n]);
       if (ImGui::Selectable(items[n].c_str(), is_selected)) {
         // set a new backend
-        backend = items[n];
-        resetTriangulation();
+        ctx.backend = items[n];
+        resetTriangulation(ctx);
       }
       if (is_selected) ImGui::SetItemDefaultFocus();
     }
@@ -258,7 +622,7 @@ void myCallback() {
   }
 
   ImGui::TextUnformatted("Intrinsic triangulation:");
-  ImGui::Text("  nVertices = %lu  nFaces = %lu", intTri->mesh.nVertices(), intTri->mesh.nFaces());
+  ImGui::Text("  nVertices = %lu  nFaces = %lu", ctx.pipeline.nVertices(), ctx.pipeline.nFaces());
   if (intTriIsDelaunay) {
     ImGui::Text("  is Delaunay: yes | min valid angle = %.2f degrees", intTriMinValidAngleDeg);
   } else {
@@ -266,119 +630,375 @@ void myCallback() {
   }
 
   if (ImGui::Button("reset triangulation")) {
-    resetTriangulation();
+    resetTriangulation(ctx);
   }
 
   if (ImGui::TreeNode("Delaunay flipping")) {
     if (ImGui::Button("flip to Delaunay")) {
-      flipDelaunayTriangulation();
+      flipDelaunayTriangulation(ctx);
+      if (updateTracedEdgesAfterEdits) showTracedEdges(ctx);
     }
     ImGui::TreePop();
   }
 
   if (ImGui::TreeNode("Delaunay refinement")) {
-    ImGui::InputFloat("degree threshold", &refineDegreeThresh);
+    ImGui::InputFloat("degree threshold", &ctx.refineDegreeThresh);
 
-    ImGui::Checkbox("refine large triangles", &useRefineSizeThresh);
-    if (useRefineSizeThresh) {
-      ImGui::InputFloat("size threshold (circumradius)", &refineToSize);
+    ImGui::Checkbox("refine large triangles", &ctx.useRefineSizeThresh);
+    if (ctx.useRefineSizeThresh) {
+      ImGui::InputFloat("size threshold (circumradius)", &ctx.refineToSize);
     }
 
-    ImGui::Checkbox("limit number of insertions", &useInsertionsMax);
-    if (useInsertionsMax) {
-      ImGui::InputInt("num insertions", &insertionsMax);
+    ImGui::Checkbox("limit number of insertions", &ctx.useInsertionsMax);
+    if (ctx.useInsertionsMax) {
+      ImGui::InputInt("num insertions", &ctx.insertionsMax);
     }
 
     if (ImGui::Button("Delaunay refine")) {
-      refineDelaunayTriangulation();
+      refineDelaunayTriangulation(ctx);
+      if (updateTracedEdgesAfterEdits) showTracedEdges(ctx);
     }
     ImGui::TreePop();
   }
 
   if (ImGui::Button("Construct common subdivision")) {
-    computeCommonSubdivision();
+    computeCommonSubdivision(ctx);
+  }
+  if (ImGui::Button("Show traced edges")) {
+    showTracedEdges(ctx);
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("update after edits", &updateTracedEdgesAfterEdits);
+
+  if (polyscope::hasSurfaceMesh("common subdivision")) {
+    ImGui::TextUnformatted("Common subdivision coloring:");
+    ImGui::SameLine();
+    int coloring = subdivisionColors.showInput ? 1 : 0;
+    bool changed = ImGui::RadioButton("intrinsic", &coloring, 0);
+    ImGui::SameLine();
+    changed |= ImGui::RadioButton("input", &coloring, 1);
+    if (changed) {
+      subdivisionColors.showInput = coloring == 1;
+      showSubdivisionColoring();
+    }
+  }
+
+  if (ImGui::TreeNode("Level of detail")) {
+    ImGui::InputInt("max common subdivision faces", &maxShownSubdivisionFaces);
+    ImGui::InputInt("max edge nodes", &maxShownEdgeNodes);
+    if (ImGui::Button("show full common subdivision")) showCommonSubdivision(ctx, true);
+    ImGui::TreePop();
   }
 
   if (ImGui::TreeNode("Output")) {
 
-    if (ImGui::Button("intrinsic faces")) outputIntrinsicFaces();
-    if (ImGui::Button("vertex positions")) outputVertexPositions();
-    if (ImGui::Button("Laplace matrix")) outputLaplaceMat();
-    if (ImGui::Button("interpolate matrix")) outputInterpolatMat();
-    if (ImGui::Button("function transfer matrices")) outputFunctionTransferMat();
-    if (ImGui::Button("common subdivision")) outputCommonSubdivision();
+    if (ImGui::Button("intrinsic faces")) outputIntrinsicFaces(ctx);
+    if (ImGui::Button("vertex positions")) outputVertexPositions(ctx);
+    if (ImGui::Button("Laplace matrix")) outputLaplaceMat(ctx);
+    if (ImGui::Button("mass matrix")) outputMassMat(ctx);
+    if (ImGui::Button("interpolate matrix")) outputInterpolatMat(ctx);
+    if (ImGui::Button("function transfer matrices")) outputFunctionTransferMat(ctx);
+    if (ImGui::Button("common subdivision")) outputCommonSubdivision(ctx);
 
     ImGui::TreePop();
   }
 
   ImGui::PopItemWidth();
 }
+#endif
+
+// Operations and outputs requested on the command line. These are applied to every mesh processed by a run.
+struct ProcessingOptions {
+  std::string backend = "Integer Coordinates"; // or "auto" or "both", which pick a backend for each mesh
+  float refineDegreeThresh = 25;
+  float refineToSize = std::numeric_limits<float>::infinity();
+
+  bool triangulateInput = false;
+  std::string meshCache; // directory for cached binary copies of the input meshes, if not empty
+  bool flipDelaunay = false;
+  bool refineDelaunay = false;
+  int refineMaxInsertions = -10;
+  double flipTimeBudget = std::numeric_limits<double>::infinity();   // seconds
+  double refineTimeBudget = std::numeric_limits<double>::infinity(); // seconds
+  bool reportProgress = false;
+  int traceThreads = -1;  // trace with geometry-central's common subdivision if negative
+  std::string saveTriangulation; // file to save the triangulation to after flipping and refinement, if not empty
+  std::string loadTriangulation; // file to load the triangulation from instead of computing it, if not empty
+
+  bool intrinsicFaces = false;
+  bool vertexPositions = false;
+  bool laplaceMat = false;
+  bool massMat = false;
+  bool interpolateMat = false;
+  bool functionTransferMat = false;
+  std::string transferFunction; // file of functions to transfer, if not empty
+  bool transferToIntrinsic = true;
+  bool transferToInput = true;
+  std::string sampleAttributes; // file of input vertex attributes to sample at the intrinsic vertices, if not empty
+  std::string heatGeodesic;     // file of source vertex sets to compute geodesic distance from, if not empty
+  std::string poissonSolve;     // file of right-hand sides to solve the Poisson equation for, if not empty
+  bool commonSubdivision = false;
+  std::string compactCommonSubdivision; // "exact" or "quantized" to trace into a CompactCommonSubdivision, or empty
+  std::string commonSubdivisionRegion; // file listing the faces to trace the common subdivision over, if not empty
+  bool regionOnInput = true;           // whether those are input faces, rather than intrinsic faces
+  bool logStats = false;
+  bool deterministic = false;
+  MatrixFormat outputFormat = MatrixFormat::ASCII;
+};
+
+// One mesh of a batch run, along with the prefix for its output files
+struct BatchEntry {
+  std::string meshFilename;
+  std::string outputPrefix;
+};
+
+// Read a batch manifest with one mesh per line. A line may optionally give the output prefix for that mesh after a
+// tab; otherwise the prefix is defaultPrefix followed by the mesh name. Blank lines and lines starting with '#' are
+// skipped.
+std::vector<BatchEntry> readBatchManifest(std::istream& in, std::string defaultPrefix) {
+  std::vector<BatchEntry> entries;
+  std::string line;
+  while (std::getline(in, line)) {
+    // strip trailing whitespace (including '\r' from windows line endings)
+    size_t end = line.find_last_not_of(" \t\r\n");
+    if (end == std::string::npos) continue;
+    line = line.substr(0, end + 1);
+    if (line[0] == '#') continue;
+
+    BatchEntry entry;
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos) {
+      entry.meshFilename = line;
+      entry.outputPrefix = defaultPrefix + meshNameFromPath(line) + "_";
+    } else {
+      entry.meshFilename = line.substr(0, tab);
+      entry.outputPrefix = line.substr(tab + 1);
+    }
+    entries.push_back(entry);
+  }
+  return entries;
+}
 
-int main(int argc, char** argv) {
-
-  // Configure the argument parser
-  // clang-format off
-  args::ArgumentParser parser("A demo of Integer Coordinates for Intrinsic Geometry Processing");
-  args::HelpFlag help(parser, "help", "Display this help message", {'h', "help"});
-  args::Positional<std::string> inputFilename(parser, "mesh", "A .obj or .ply mesh file.");
+// Cheaply estimate the number of vertices in a mesh file without loading it, used to schedule the largest meshes
+// first. Reads the header of .ply and .off files and counts vertex lines in .obj files; anything else (or any file
+// whose header we do not understand) is estimated from its size in bytes.
+size_t estimateVertexCount(std::string filename) {
+  std::ifstream in(filename, std::ios::binary | std::ios::ate);
+  if (!in.is_open()) return 0;
+  size_t fileSize = static_cast<size_t>(in.tellg());
+  in.seekg(0);
+
+  std::string ext = filename.substr(filename.find_last_of('.') + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+  std::string line;
+  if (ext == "ply") {
+    while (std::getline(in, line) && line.compare(0, 10, "end_header") != 0) {
+      std::istringstream ss(line);
+      std::string keyword, element;
+      size_t count;
+      if (ss >> keyword >> element >> count && keyword == "element" && element == "vertex") return count;
+    }
+  } else if (ext == "off") {
+    // The counts follow the OFF keyword, either on the same line or on the next non-comment line
+    bool sawKeyword = false;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      std::istringstream ss(line);
+      if (!sawKeyword) {
+        std::string keyword;
+        ss >> keyword;
+        sawKeyword = true;
+      }
+      size_t count;
+      if (ss >> count) return count;
+    }
+  } else if (ext == "obj") {
+    size_t count = 0;
+    while (std::getline(in, line)) {
+      if (line.size() > 1 && line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) count++;
+    }
+    return count;
+  }
 
-  args::Group triangulation(parser, "triangulation");
-  args::ValueFlag<std::string> backendFlag(triangulation, "backend", "Data structure to use (signpost or integer)", {"backend"});
-  args::Flag flipDelaunay(triangulation, "flipDelaunay", "Flip edges to make the mesh intrinsic Delaunay", {"flipDelaunay"});
-  args::Flag refineDelaunay(triangulation, "refineDelaunay", "Refine and flip edges to make the mesh intrinsic Delaunay and satisfy angle/size bounds", {"refineDelaunay"});
-  args::ValueFlag<double> refineAngle(triangulation, "refineAngle", "Minimum angle threshold (in degrees). Default: 25.", {"refineAngle"}, 25.);
-  args::ValueFlag<double> refineSizeCircum(triangulation, "refineSizeCircum", "Maximum triangle size, set by specifying the circumradius. Default: inf", {"refineSizeCircum"}, std::numeric_limits<double>::infinity());
-  args::ValueFlag<int> refineMaxInsertions(triangulation, "refineMaxInsertions",
-      "Maximum number of insertions during refinement. Use 0 for no max, or negative values to scale by number of vertices. Default: 10 * nVerts",
-      {"refineMaxInsertions"}, -10);
-  args::Flag triangulateInput(triangulation, "triangulateInput", "Triangulate non-triangular faces of input", {"triangulateInput"});
+  return fileSize;
+}
 
-  args::Group output(parser, "ouput");
-  args::Flag noGUI(output, "noGUI", "exit after processing and do not open the GUI", {"noGUI"});
-  args::ValueFlag<std::string> outputPrefixArg(output, "outputPrefix", "Prefix to prepend to all output file paths. Default: intrinsic_", {"outputPrefix"}, "intrinsic_");
-  args::Flag intrinsicFaces(output, "edgeLengths", "write the face information for the intrinsic triangulation. name: 'faceInds.dmat, faceLengths.dmat'", {"intrinsicFaces"});
-  args::Flag vertexPositions(output, "vertexPositions", "write the vertex positions for the intrinsic triangulation. name: 'vertexPositions.dmat'", {"vertexPositions"});
-  args::Flag laplaceMat(output, "laplaceMat", "write the Laplace-Beltrami matrix for the triangulation. name: 'laplace.spmat'", {"laplaceMat"});
-  args::Flag interpolateMat(output, "interpolateMat", "write the matrix which expresses data on the intrinsic vertices as a linear combination of the input vertices. name: 'interpolate.mat'", {"interpolateMat"});
-  args::Flag functionTransferMat(output, "functionTransferMat", "write the linear systems for L2-optimal function transfer between the input and intrinsic triangulations. name: 'InputToIntrinsic_lhs.spmat', 'InputToIntrinsic_rhs.spmat', etc.", {"functionTransferMat"});
-  args::Flag commonSubdivision(output, "commonSubdivision", "write the common subdivision to an obj file. name: 'common_subdivision.obj'.", {"commonSubdivision"});
-  args::Flag logStats(output, "logStats", "write performance statistics. name: 'stats.tsv'", {"logStats"});
-  // clang-format on
+// Run one stage of the pipeline as a timed phase
+void runPhase(MeshContext& ctx, std::string name, void (*stage)(MeshContext&)) {
+  PhaseTimer::Scope phase(ctx.timer, name);
+  stage(ctx);
+}
 
+// Release all geometry-central data for a mesh
+void clearMeshState(MeshContext& ctx) {
+  ctx.writer.reset();
+  ctx.compactCS.reset();
+  ctx.regionalCS.reset();
+  ctx.pipeline.clear();
+}
 
-  // Parse args
-  try {
-    parser.ParseCLI(argc, argv);
-  } catch (const args::Help& h) {
-    std::cout << parser;
-    return 0;
-  } catch (const args::ParseError& e) {
-    std::cerr << e.what() << std::endl;
-    std::cerr << parser;
-    return 1;
+// Generate all requested outputs
+void writeOutputs(MeshContext& ctx, const ProcessingOptions& options) {
+  PhaseTimer::Scope outputPhase(ctx.timer, "output");
+  ctx.writer.reset(new AsyncFileWriter());
+  IntrinsicOutputs intrinsicOutputs;
+  intrinsicOutputs.intrinsicFaces = options.intrinsicFaces;
+  intrinsicOutputs.vertexPositions = options.vertexPositions;
+  intrinsicOutputs.laplaceMat = options.laplaceMat;
+  intrinsicOutputs.massMat = options.massMat;
+  intrinsicOutputs.interpolateMat = options.interpolateMat;
+  if (intrinsicOutputs.any()) {
+    PhaseTimer::Scope phase(ctx.timer, "intrinsicTriangulation");
+    outputIntrinsicTriangulation(ctx, intrinsicOutputs);
   }
-
-  // Make sure a mesh name was given
-  if (!inputFilename) {
-    std::cout << parser;
-    return EXIT_FAILURE;
+  if (!ctx.sampleAttributes.empty()) runPhase(ctx, "sampleAttributes", outputSampledAttributes);
+  if (!ctx.heatGeodesic.empty()) runPhase(ctx, "heatGeodesic", outputHeatGeodesic);
+  if (!ctx.poissonSolve.empty()) runPhase(ctx, "poissonSolve", outputPoissonSolution);
+  if (options.functionTransferMat) runPhase(ctx, "functionTransferMat", outputFunctionTransferMat);
+  if (!ctx.transferFunction.empty()) runPhase(ctx, "transferFunction", outputTransferredFunctions);
+  if (options.commonSubdivision) runPhase(ctx, "commonSubdivision", outputCommonSubdivision);
+  if (ctx.regionalCS) runPhase(ctx, "commonSubdivisionRegion", outputCommonSubdivisionRegion);
+
+  // All files are on disk before the log records that processing finished
+  {
+    PhaseTimer::Scope phase(ctx.timer, "flush");
+    ctx.writer->finish();
+    ctx.writer.reset();
   }
+}
 
-  // Set options
-  withGUI = !noGUI;
+// Triangulate the input mesh with each backend in turn, flipping, refining and tracing it as requested, and keep
+// whichever backend's triangulation took less time in all. The time each step took with each backend is logged as
+// the phase compareBackends/<backend>/<step>, and each backend's total as compare/<backend>Seconds.
+//
+// A backend whose flips or refinement stopped early (at a time budget, or on SIGINT) took less time only because it
+// did less work, so it is kept only if every backend stopped early. After a SIGINT, no further backend is started.
+// Returns the time the kept triangulation took to trace, or -1 if it was not traced; its common subdivision (or with
+// compactTrace, its CompactCommonSubdivision, in ctx.compactCS) is kept, so it need not be traced again.
+double compareBackends(MeshContext& ctx, const ProcessingOptions& options, bool traces, bool compactTrace,
+                       Logger& logger) {
+  PhaseTimer::Scope comparePhase(ctx.timer, "compareBackends");
+  struct Run {
+    std::unique_ptr<IntrinsicTriangulation> intTri;
+    std::unique_ptr<CompactCommonSubdivision> compactCS;
+    std::string backend, key, flipStatus, refineStatus;
+    double seconds = std::numeric_limits<double>::infinity();
+    double flipSeconds = -1, refineSeconds = -1, traceSeconds = -1;
+    bool complete = false;
+  };
+  Run kept;
+
+  const std::array<std::string, 2> backends = {"Integer Coordinates", "Signposts"};
+  for (const std::string& backend : backends) {
+    if (kept.intTri && interrupted) break;
+    Run run;
+    run.backend = backend;
+    run.key = backend == "Signposts" ? "signpost" : "integer";
+    if (ctx.verbose) std::cout << "Timing the " << backend << " backend" << std::endl;
+    PhaseTimer::Scope backendPhase(ctx.timer, run.key);
+    ctx.backend = backend;
+    ctx.flipStatus = ctx.refineStatus = "complete";
+    run.seconds = 0;
+    {
+      PhaseTimer::Scope phase(ctx.timer, "resetTriangulation");
+      resetTriangulation(ctx);
+      run.seconds += phase.stop();
+    }
+    if (options.flipDelaunay) {
+      PhaseTimer::Scope phase(ctx.timer, "flip");
+      flipDelaunayTriangulation(ctx);
+      run.flipSeconds = phase.stop();
+      run.seconds += run.flipSeconds;
+    }
+    if (options.refineDelaunay) {
+      PhaseTimer::Scope phase(ctx.timer, "refine");
+      refineDelaunayTriangulation(ctx);
+      run.refineSeconds = phase.stop();
+      run.seconds += run.refineSeconds;
+    }
+    if (traces) {
+      // geometry-central's common subdivision is cached in the triangulation, and the compact one is kept with it
+      PhaseTimer::Scope phase(ctx.timer, "trace");
+      if (compactTrace) {
+        run.compactCS.reset(new CompactCommonSubdivision(ctx.pipeline.intrinsicTriangulation(),
+                                                         ctx.traceThreads >= 0 ? ctx.traceThreads : 1,
+                                                         options.compactCommonSubdivision == "quantized"));
+      } else {
+        traceCommonSubdivision(ctx);
+      }
+      run.traceSeconds = phase.stop();
+      run.seconds += run.traceSeconds;
+    }
+    backendPhase.stop();
+    run.flipStatus = ctx.flipStatus;
+    run.refineStatus = ctx.refineStatus;
+    run.complete = run.flipStatus == "complete" && run.refineStatus == "complete";
+    run.intTri = ctx.pipeline.releaseTriangulation();
+
+    if (ctx.verbose) {
+      std::cout << "\t" << backend << " took " << run.seconds << "s" << (run.complete ? "" : ", stopping early")
+                << std::endl;
+    }
+    if (options.logStats) {
+      logger.log("compare/" + run.key + "Seconds", run.seconds);
+      logger.log("compare/" + run.key + "StoppedEarly", !run.complete);
+    }
+    bool better = !kept.intTri || (run.complete && !kept.complete) ||
+                  (run.complete == kept.complete && run.seconds < kept.seconds);
+    if (better) kept = std::move(run);
+  }
 
-  refineDegreeThresh = args::get(refineAngle);
-  refineToSize = args::get(refineSizeCircum);
-  useRefineSizeThresh = refineToSize < std::numeric_limits<double>::infinity();
-  insertionsMax = args::get(refineMaxInsertions);
-  useInsertionsMax = insertionsMax != 0;
-  outputPrefix = args::get(outputPrefixArg);
+  ctx.regionalCS.reset();
+  ctx.pipeline.setTriangulation(std::move(kept.intTri), kept.backend);
+  ctx.compactCS = std::move(kept.compactCS);
+  ctx.backend = kept.backend;
+  ctx.flipStatus = kept.flipStatus;
+  ctx.refineStatus = kept.refineStatus;
+  if (ctx.verbose) std::cout << "Keeping the " << kept.backend << " triangulation" << std::endl;
+  if (options.logStats) {
+    logger.log("compare/fasterBackend", kept.key);
+    if (options.flipDelaunay) {
+      logger.log("flippingDuration", kept.flipSeconds);
+      logger.log("flipStatus", kept.flipStatus);
+    }
+    if (options.refineDelaunay) {
+      logger.log("refinementDuration", kept.refineSeconds);
+      logger.log("refineStatus", kept.refineStatus);
+    }
+  }
+  return kept.traceSeconds;
+}
 
-  if (logStats) {
+// Load a mesh, run all requested operations on it, and write the requested outputs, recording statistics in logger.
+// Throws on failure.
+void runMeshStages(MeshContext& ctx, std::string meshFilename, const ProcessingOptions& options, Logger& logger) {
+
+  ctx.backend = options.backend;
+  ctx.outputFormat = options.outputFormat;
+  ctx.transferToIntrinsic = options.transferToIntrinsic;
+  ctx.transferToInput = options.transferToInput;
+  ctx.transferFunction = options.transferFunction;
+  ctx.sampleAttributes = options.sampleAttributes;
+  ctx.heatGeodesic = options.heatGeodesic;
+  ctx.poissonSolve = options.poissonSolve;
+  ctx.hashOutputs = options.deterministic;
+  ctx.outputHashes.clear();
+  ctx.pipeline.flipTimeBudget = options.flipTimeBudget;
+  ctx.pipeline.refineTimeBudget = options.refineTimeBudget;
+  ctx.pipeline.cancel = &interrupted;
+  ctx.pipeline.progress = nullptr;
+  if (options.reportProgress && ctx.verbose) ctx.pipeline.progress = progressReporter();
+  ctx.traceThreads = options.traceThreads;
+  ctx.refineDegreeThresh = options.refineDegreeThresh;
+  ctx.refineToSize = options.refineToSize;
+  ctx.useRefineSizeThresh = ctx.refineToSize < std::numeric_limits<float>::infinity();
+
+  if (options.logStats && !ctx.statsStream) {
     // output a temporary symbol so we can tell if the program
     // crashes before writing the real log
 
-    std::string logFile = outputPrefix + "stats.tsv";
+    std::string logFile = ctx.outputPrefix + "stats.tsv";
     std::ofstream out;
 
     // std::ios::trunc ensures that we overwrite old versions
@@ -391,31 +1011,21 @@ int main(int argc, char** argv) {
     }
   }
 
-  if (backendFlag) {
-    if (args::get(backendFlag) == "signpost") {
-      backend = "Signposts";
-    } else if (args::get(backendFlag) == "integer") {
-      backend = "Integer Coordinates";
-    } else {
-      std::cout << "Error: unrecognized backend '" << args::get(backendFlag) << "'. Please use 'signpost' or 'integer'"
-                << std::endl;
-      return EXIT_FAILURE;
-    }
-  }
-
-  // Load mesh
-  std::tie(mesh, geometry) = readManifoldSurfaceMesh(args::get(inputFilename));
-
-  if (triangulateInput && !mesh->isTriangular()) {
-    std::cout << "triangulating faces..." << std::endl;
-    for (Face f : mesh->faces()) mesh->triangulate(f);
-  }
+  // Load mesh, triangulating the polygons before the mesh is built if requested
+  PhaseTimer::Scope loadPhase(ctx.timer, "load");
+  if (options.triangulateInput && ctx.verbose) std::cout << "triangulating faces..." << std::endl;
+  ctx.pipeline.loadMesh(meshFilename, options.triangulateInput, options.meshCache);
+  ManifoldSurfaceMesh& mesh = ctx.pipeline.inputMesh();
+  loadPhase.stop();
 
   // Sale max insertions by number of vertices if needed
-  if (insertionsMax < 0) {
-    insertionsMax *= -mesh->nVertices();
+  ctx.insertionsMax = options.refineMaxInsertions;
+  ctx.useInsertionsMax = ctx.insertionsMax != 0;
+  if (ctx.insertionsMax < 0) {
+    ctx.insertionsMax *= -mesh.nVertices();
   }
 
+#ifndef INT_TRI_HEADLESS
   if (withGUI) {
 
     // Initialize polyscope
@@ -425,99 +1035,584 @@ int main(int argc, char** argv) {
     polyscope::state::userCallback = myCallback;
 
     // Register the mesh with polyscope
-    psMesh = polyscope::registerSurfaceMesh(polyscope::guessNiceNameFromPath(args::get(inputFilename)),
-                                            geometry->inputVertexPositions, mesh->getFaceVertexList(),
-                                            polyscopePermutations(*mesh));
+    psMesh = polyscope::registerSurfaceMesh(meshNameFromPath(meshFilename),
+                                            ctx.pipeline.inputGeometry().inputVertexPositions, mesh.getFaceVertexList(),
+                                            polyscopePermutations(mesh));
 
     // Nice defaults
     psMesh->setEdgeWidth(1.0);
   }
+#endif
+
+  // A shared stats file only gets the final row, written by processMesh()
+  auto saveLog = [&]() {
+    // The process-wide peak also counts any meshes processed alongside this one
+    if (!ctx.timer.isConcurrent()) logger.log("peakRSSMB", peakResidentSetBytes() / BYTES_PER_MB);
+    for (const std::pair<std::string, uint64_t>& hash : ctx.outputHashes) {
+      logger.log("hash/" + hash.first, hashToHex(hash.second));
+    }
+    ctx.timer.log(logger);
+    if (!ctx.statsStream) writeLog(logger, ctx.outputPrefix);
+  };
+
+  // Start from a saved triangulation instead of recomputing it
+  if (!options.loadTriangulation.empty()) {
+    PhaseTimer::Scope phase(ctx.timer, "loadTriangulation");
+    if (ctx.verbose) std::cout << "Loading intrinsic triangulation from " << options.loadTriangulation << std::endl;
+    ctx.pipeline.loadTriangulation(options.loadTriangulation);
+    phase.stop();
+    if (options.logStats) {
+      logger.log("name", meshNameFromPath(meshFilename));
+      logger.log("inputVertices", mesh.nVertices());
+      logger.log("outputVertices", ctx.pipeline.nVertices());
+    }
 
-  Logger logger;
+    writeOutputs(ctx, options);
+    if (options.logStats) saveLog();
+    return;
+  }
 
-  // Initialize triangulation
-  resetTriangulation();
+  // With --traceThreads or --compactCommonSubdivision, the statistics come from tracing every edge in parallel into a
+  // CompactCommonSubdivision, and geometry-central's common subdivision is only built if something needs its faces.
+  // The GUI shows geometry-central's common subdivision, but builds its mesh only if it is small enough to show.
+  bool compact = !options.compactCommonSubdivision.empty();
+  bool needsFaces = options.functionTransferMat || !options.transferFunction.empty() ||
+                    (options.commonSubdivision && !compact);
+  bool tracesEdges = options.commonSubdivisionRegion.empty() && (ctx.traceThreads >= 0 || compact);
+  bool meshesForStats = options.commonSubdivisionRegion.empty() && !tracesEdges;
+  bool needsCommonSubdivision = needsFaces || meshesForStats || withGUI;
+
+  bool performedOperation = options.flipDelaunay || options.refineDelaunay;
+  bool traces = performedOperation && (tracesEdges || needsCommonSubdivision);
+
+  // Pick the backend expected to be faster from the input mesh and what will be done with it
+  if (options.backend == "auto" || options.backend == "both") {
+    PhaseTimer::Scope phase(ctx.timer, "chooseBackend");
+    BackendWorkload workload;
+    workload.flip = options.flipDelaunay;
+    workload.refine = options.refineDelaunay;
+    workload.traceCommonSubdivision = traces;
+    ctx.backend = chooseBackend(meshFeatures(mesh, ctx.pipeline.inputGeometry()), workload);
+    if (ctx.verbose) std::cout << "Chose the " << ctx.backend << " backend" << std::endl;
+    if (options.logStats) logger.log("autoBackend", ctx.backend == "Signposts" ? "signpost" : "integer");
+  }
 
-  if (logStats) {
-    logger.log("name", polyscope::guessNiceNameFromPath(args::get(inputFilename)));
-    logger.log("inputVertices", mesh->nVertices());
-    logger.log("inputIsDelaunay", intTri->isDelaunay());
-    logger.log("inputMinAngleDeg", intTri->minAngleDegrees());
-    logger.log("inputMinValidAngleDeg", intTri->minAngleDegreesAtValidFaces(60));
+  // Initialize triangulation
+  PhaseTimer::Scope resetPhase(ctx.timer, "resetTriangulation");
+  resetTriangulation(ctx);
+  resetPhase.stop();
+
+  if (options.logStats) {
+    PhaseTimer::Scope phase(ctx.timer, "inputStats");
+    logger.log("name", meshNameFromPath(meshFilename));
+    logger.log("inputVertices", mesh.nVertices());
+    IntrinsicTriangulation& inputTri = ctx.pipeline.intrinsicTriangulation();
+    logger.log("inputIsDelaunay", inputTri.isDelaunay());
+    logger.log("inputMinAngleDeg", inputTri.minAngleDegrees());
+    logger.log("inputMinValidAngleDeg", inputTri.minAngleDegreesAtValidFaces(60));
   }
 
-  // Perform any operations requested
-  bool performedOperation = false;
-  if (flipDelaunay) {
-    std::clock_t start = std::clock();
-    flipDelaunayTriangulation();
-    double duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    if (logStats) logger.log("flippingDuration", duration);
-    performedOperation = true;
+  // Perform any operations requested, with each backend in turn for --backend both
+  double comparedTraceSeconds = -1;
+  if (options.backend == "both") {
+    comparedTraceSeconds = compareBackends(ctx, options, traces, tracesEdges, logger);
+  } else {
+    if (options.flipDelaunay) {
+      PhaseTimer::Scope phase(ctx.timer, "flip");
+      flipDelaunayTriangulation(ctx);
+      double duration = phase.stop();
+      if (options.logStats) {
+        logger.log("flippingDuration", duration);
+        logger.log("flipStatus", ctx.flipStatus);
+      }
+    }
+
+    if (options.refineDelaunay) {
+      PhaseTimer::Scope phase(ctx.timer, "refine");
+      refineDelaunayTriangulation(ctx);
+      double duration = phase.stop();
+      if (options.logStats) {
+        logger.log("refinementDuration", duration);
+        logger.log("refineStatus", ctx.refineStatus);
+      }
+    }
   }
 
-  if (refineDelaunay) {
-    std::clock_t start = std::clock();
-    refineDelaunayTriangulation();
-    double duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    if (logStats) logger.log("refinementDuration", duration);
-    performedOperation = true;
+  IntrinsicTriangulation& intTri = ctx.pipeline.intrinsicTriangulation();
+
+  if (!options.saveTriangulation.empty()) {
+    PhaseTimer::Scope phase(ctx.timer, "saveTriangulation");
+    if (ctx.verbose) std::cout << "Saving intrinsic triangulation to " << options.saveTriangulation << std::endl;
+    ctx.pipeline.saveTriangulation(options.saveTriangulation);
   }
 
-  if (logStats) {
-    logger.log("outputVertices", intTri->intrinsicMesh->nVertices());
-    logger.log("outputIsDelaunay", intTri->isDelaunay());
-    logger.log("outputMinAngleDeg", intTri->minAngleDegrees());
-    logger.log("outputMinValidAngleDeg", intTri->minAngleDegreesAtValidFaces(60));
+  if (options.logStats) {
+    PhaseTimer::Scope phase(ctx.timer, "outputStats");
+    logger.log("backend", ctx.backend == "Signposts" ? "signpost" : "integer");
+    logger.log("outputVertices", intTri.intrinsicMesh->nVertices());
+    logger.log("outputIsDelaunay", intTri.isDelaunay());
+    logger.log("outputMinAngleDeg", intTri.minAngleDegrees());
+    logger.log("outputMinValidAngleDeg", intTri.minAngleDegreesAtValidFaces(60));
+    logger.log("intrinsicTriangulationMB", intrinsicTriangulationBytes(intTri) / BYTES_PER_MB);
+    if (IntegerCoordinatesIntrinsicTriangulation* intCoords =
+            dynamic_cast<IntegerCoordinatesIntrinsicTriangulation*>(&intTri)) {
+      logger.log("normalCoordinatesMB", normalCoordinatesBytes(intCoords->normalCoordinates) / BYTES_PER_MB);
+    } else {
+      // every row of a shared stats file has the column, whichever backend each mesh used
+      logger.log("normalCoordinatesMB", -1);
+    }
+    phase.stop();
 
     if (performedOperation) {
       // log dummy value in case we time out
       logger.log("commonSubdivisionTracingDuration", -1);
       logger.log("commonSubdivisionMeshingDuration", -1);
       logger.log("commonSubdivisionVertices", -1);
+      logger.log("commonSubdivisionMB", -1);
     }
 
-    if (logStats) writeLog(logger, outputPrefix);
+    saveLog();
   }
 
-  if (performedOperation) {
-    // compute common subdivision
-    std::clock_t start = std::clock();
-    computeCommonSubdivision();
-    CommonSubdivision& cs = intTri->getCommonSubdivision();
-    double duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    if (logStats) {
+  // Trace just the region, unless an output needs the whole common subdivision
+  if (!options.commonSubdivisionRegion.empty()) {
+    PhaseTimer::Scope phase(ctx.timer, "commonSubdivisionRegion");
+    ctx.regionalCS.reset(new RegionalCommonSubdivision(intTri));
+    std::vector<Face> regionFaces;
+    if (options.regionOnInput) {
+      for (size_t iF : readFaceIndices(options.commonSubdivisionRegion, mesh.nFaces())) {
+        regionFaces.push_back(mesh.face(iF));
+      }
+      regionFaces = ctx.regionalCS->intrinsicFacesOver(regionFaces);
+    } else {
+      // Intrinsic faces are numbered as in the faceInds output
+      std::vector<Face> intrinsicFaces;
+      for (Face f : intTri.intrinsicMesh->faces()) intrinsicFaces.push_back(f);
+      for (size_t iF : readFaceIndices(options.commonSubdivisionRegion, intrinsicFaces.size())) {
+        regionFaces.push_back(intrinsicFaces[iF]);
+      }
+    }
+    ctx.regionalCS->addIntrinsicFaces(regionFaces);
+    ctx.regionalCS->update(ctx.traceThreads >= 0 ? ctx.traceThreads : 1);
+    if (ctx.verbose) {
+      std::cout << "Traced " << ctx.regionalCS->nTracedEdges() << " intrinsic edges over " << regionFaces.size()
+                << " intrinsic faces" << std::endl;
+    }
+    if (options.logStats) {
+      logger.log("regionIntrinsicFaces", regionFaces.size());
+      logger.log("regionTracedEdges", ctx.regionalCS->nTracedEdges());
+    }
+  } else if (options.logStats) {
+    logger.log("regionIntrinsicFaces", -1);
+    logger.log("regionTracedEdges", -1);
+  }
+  if (traces) {
+    PhaseTimer::Scope csPhase(ctx.timer, "commonSubdivision");
+
+    // trace the common subdivision
+    PhaseTimer::Scope tracePhase(ctx.timer, "trace");
+    if (ctx.verbose) std::cout << "Tracing common subdivision" << std::endl;
+    size_t nVertices;
+    if (tracesEdges) {
+      if (!ctx.compactCS) {
+        ctx.compactCS.reset(new CompactCommonSubdivision(intTri, ctx.traceThreads >= 0 ? ctx.traceThreads : 1,
+                                                         options.compactCommonSubdivision == "quantized"));
+      }
+      nVertices = ctx.compactCS->nVertices();
+    } else {
+      nVertices = traceCommonSubdivision(ctx).nVertices();
+    }
+    if (ctx.verbose) std::cout << "\t...done" << std::endl;
+    double duration = tracePhase.stop();
+
+    // --backend both has already traced the kept triangulation, and timed it then
+    if (comparedTraceSeconds >= 0) duration = comparedTraceSeconds;
+    if (options.logStats) {
       logger.log("commonSubdivisionTracingDuration", duration);
-      logger.log("commonSubdivisionVertices", cs.nVertices());
-      writeLog(logger, outputPrefix);
+      logger.log("commonSubdivisionVertices", nVertices);
+      if (tracesEdges) logger.log("compactCommonSubdivisionMB", ctx.compactCS->sizeInBytes() / BYTES_PER_MB);
+      saveLog();
     }
+    if (!compact) ctx.compactCS.reset();
+  }
+
+  if (performedOperation && needsCommonSubdivision) {
+    PhaseTimer::Scope csPhase(ctx.timer, "commonSubdivision");
+    CommonSubdivision& cs = traceCommonSubdivision(ctx);
+    bool meshes = needsFaces || meshesForStats;
+#ifndef INT_TRI_HEADLESS
+    // the GUI builds the mesh anyway if it is shown, and otherwise it is not worth building for the statistics
+    if (withGUI && !needsFaces) meshes = showsSubdivisionMesh(cs);
+#endif
 
     // extract mesh of common subdivision
-    start = std::clock();
-    std::cout << "Constructing common subdivision mesh" << std::endl;
-    cs.constructMesh();
-    std::cout << "\t...done" << std::endl;
-    duration = (std::clock() - start) / (double)CLOCKS_PER_SEC;
-    if (logStats) {
-      logger.log("commonSubdivisionMeshingDuration", duration);
-      writeLog(logger, outputPrefix);
+    if (meshes) {
+      PhaseTimer::Scope meshPhase(ctx.timer, "mesh");
+      if (ctx.verbose) std::cout << "Constructing common subdivision mesh" << std::endl;
+      meshCommonSubdivision(ctx);
+      if (ctx.verbose) std::cout << "\t...done" << std::endl;
+      double duration = meshPhase.stop();
+      if (options.logStats) {
+        logger.log("commonSubdivisionMeshingDuration", duration);
+        logger.log("commonSubdivisionMB", commonSubdivisionBytes(cs) / BYTES_PER_MB);
+        saveLog();
+      }
     }
+
+#ifndef INT_TRI_HEADLESS
+    if (withGUI) showCommonSubdivision(ctx);
+#endif
   }
 
   // Generate any outputs
-  if (intrinsicFaces) outputIntrinsicFaces();
-  if (vertexPositions) outputVertexPositions();
-  if (laplaceMat) outputLaplaceMat();
-  if (interpolateMat) outputInterpolatMat();
-  if (functionTransferMat) outputFunctionTransferMat();
-  if (commonSubdivision) outputCommonSubdivision();
+  writeOutputs(ctx, options);
+
+  if (options.logStats) saveLog();
+}
+
+// Load a mesh, run all requested operations on it, and write the requested outputs. Throws on failure.
+void processMesh(MeshContext& ctx, std::string meshFilename, const ProcessingOptions& options) {
+  Logger logger;
+  if (!ctx.statsStream) {
+    runMeshStages(ctx, meshFilename, options, logger);
+    return;
+  }
+
+  // Record failed meshes too, with whatever statistics they got as far as logging
+  logger.log("name", meshNameFromPath(meshFilename));
+  logger.log("status", "failed");
+  try {
+    runMeshStages(ctx, meshFilename, options, logger);
+  } catch (...) {
+    ctx.timer.log(logger);
+    ctx.statsStream->append(logger, false);
+    throw;
+  }
+  logger.log("status", "ok");
+  ctx.statsStream->append(logger);
+}
+
+// Process every mesh in a batch manifest within this process, spread over nThreads workers. Each mesh gets its own
+// context, and a failure on one mesh is reported without stopping the run. If statsStream is given, every mesh appends its
+// statistics to it. Returns the number of meshes which failed.
+size_t processBatch(const std::vector<BatchEntry>& entries, const ProcessingOptions& options, size_t nThreads,
+                    TsvLogStream* statsStream) {
+
+  // Schedule the largest meshes first: costs vary by orders of magnitude, and starting a huge mesh last would leave
+  // every other worker idle while it finishes
+  std::vector<size_t> vertexCounts(entries.size());
+  for (size_t iE = 0; iE < entries.size(); iE++) vertexCounts[iE] = estimateVertexCount(entries[iE].meshFilename);
+  std::vector<size_t> order(entries.size());
+  for (size_t iE = 0; iE < entries.size(); iE++) order[iE] = iE;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return vertexCounts[a] > vertexCounts[b]; });
+
+  std::mutex outputMutex;
+  std::atomic<size_t> nFinished(0);
+  std::vector<char> failed(entries.size(), false);
+  bool verbose = nThreads <= 1;
+
+  std::vector<std::function<void()>> jobs;
+  for (size_t iE : order) {
+    jobs.push_back([&, iE]() {
+      const BatchEntry& entry = entries[iE];
+      if (verbose) {
+        std::cout << "=== Processing mesh " << (nFinished + 1) << " / " << entries.size() << ": " << entry.meshFilename
+                  << std::endl;
+      }
+
+      MeshContext ctx;
+      ctx.outputPrefix = entry.outputPrefix;
+      ctx.verbose = verbose;
+      ctx.statsStream = statsStream;
+      ctx.pipeline.nThreads = nThreads > 1 ? 1 : 0; // the meshes themselves already keep every thread busy
+      ctx.timer.setConcurrent(nThreads > 1);
+
+      std::string error;
+      try {
+        // After a SIGINT, the meshes already started finish from what they have, and the others are skipped
+        if (interrupted) throw std::runtime_error("interrupted before processing started");
+        processMesh(ctx, entry.meshFilename, options);
+      } catch (const std::exception& e) {
+        error = e.what();
+        failed[iE] = true;
+      } catch (...) {
+        error = "unknown error";
+        failed[iE] = true;
+      }
+      clearMeshState(ctx);
+
+      size_t iFinished = ++nFinished;
+      std::lock_guard<std::mutex> lock(outputMutex);
+      if (!error.empty()) {
+        std::cout << "Error: failed to process " << entry.meshFilename << ": " << error << std::endl;
+      }
+      if (!verbose) {
+        std::cout << "[" << iFinished << " / " << entries.size() << "] " << (error.empty() ? "done" : "FAILED")
+                  << ": " << entry.meshFilename << std::endl;
+      }
+    });
+  }
+
+  WorkStealingPool pool(nThreads);
+  pool.pushRoundRobin(std::move(jobs));
+  pool.run();
+
+  size_t nFailed = 0;
+  for (size_t iE = 0; iE < entries.size(); iE++) {
+    if (failed[iE]) nFailed++;
+  }
+  std::cout << "Processed " << entries.size() << " meshes, " << nFailed << " failed" << std::endl;
+  for (size_t iE = 0; iE < entries.size(); iE++) {
+    if (failed[iE]) std::cout << "  failed: " << entries[iE].meshFilename << std::endl;
+  }
+  return nFailed;
+}
+
+// Parse a duration such as "90", "90s", "1.5m" or "2h" into seconds, throwing if it is not one
+double parseDuration(std::string text) {
+  const char* start = text.c_str();
+  char* end;
+  double value = std::strtod(start, &end);
+  std::string unit(end);
+  double scale = unit.empty() || unit == "s" ? 1. : unit == "ms" ? 1e-3 : unit == "m" ? 60. : unit == "h" ? 3600. : -1;
+  if (end == start || scale < 0 || !(value >= 0) || value > 1e9) {
+    throw std::runtime_error("invalid duration '" + text + "'. Please give a number of seconds, or use a suffix of "
+                             "ms, s, m or h");
+  }
+  return value * scale;
+}
+
+int main(int argc, char** argv) {
+
+  // Configure the argument parser
+  // clang-format off
+  args::ArgumentParser parser("A demo of Integer Coordinates for Intrinsic Geometry Processing");
+  args::HelpFlag help(parser, "help", "Display this help message", {'h', "help"});
+  args::Positional<std::string> inputFilename(parser, "mesh", "A .obj or .ply mesh file.");
+  args::ValueFlag<std::string> batchManifest(parser, "batch", "Process every mesh listed in a manifest file (one path per line, optionally followed by a tab and an output prefix). Use '-' to read the list from stdin. Implies --noGUI", {"batch"});
+  args::ValueFlag<int> threads(parser, "threads", "Number of meshes to process concurrently in batch mode. Use 0 for one per hardware thread. Default: 1", {"threads"}, 1);
+
+  args::Group triangulation(parser, "triangulation");
+  args::ValueFlag<std::string> backendFlag(triangulation, "backend", "Data structure to use (signpost or integer), or auto to pick the one expected to be faster for each mesh, or both to time both and keep the faster", {"backend"});
+  args::Flag flipDelaunay(triangulation, "flipDelaunay", "Flip edges to make the mesh intrinsic Delaunay", {"flipDelaunay"});
+  args::Flag refineDelaunay(triangulation, "refineDelaunay", "Refine and flip edges to make the mesh intrinsic Delaunay and satisfy angle/size bounds", {"refineDelaunay"});
+  args::ValueFlag<double> refineAngle(triangulation, "refineAngle", "Minimum angle threshold (in degrees). Default: 25.", {"refineAngle"}, 25.);
+  args::ValueFlag<double> refineSizeCircum(triangulation, "refineSizeCircum", "Maximum triangle size, set by specifying the circumradius. Default: inf", {"refineSizeCircum"}, std::numeric_limits<double>::infinity());
+  args::ValueFlag<int> refineMaxInsertions(triangulation, "refineMaxInsertions",
+      "Maximum number of insertions during refinement. Use 0 for no max, or negative values to scale by number of vertices. Default: 10 * nVerts",
+      {"refineMaxInsertions"}, -10);
+  args::ValueFlag<std::string> flipTimeBudget(triangulation, "flipTimeBudget", "Stop flipping at the end of the first round past this much wall-clock time (e.g. 90s, 5m or 1h; plain numbers are seconds), and carry on from the triangulation so far. Flips in rounds of independent edges, which can stop between rounds", {"flipTimeBudget"});
+  args::ValueFlag<std::string> refineTimeBudget(triangulation, "refineTimeBudget", "Stop refining at the end of the first round past this much wall-clock time, as --flipTimeBudget does. Refines in rounds, inserting a batch of independent circumcenters per round, so the result differs from serial refinement", {"refineTimeBudget"});
+  args::Flag progress(triangulation, "progress", "Report the progress of flips and refinement in rounds every second", {"progress"});
+  args::Flag triangulateInput(triangulation, "triangulateInput", "Triangulate non-triangular faces of input", {"triangulateInput"});
+  args::ValueFlag<std::string> saveTriangulation(triangulation, "saveTriangulation", "After flipping and refinement, save the intrinsic triangulation (connectivity, edge lengths and vertex locations) to this binary file", {"saveTriangulation"});
+  args::ValueFlag<std::string> loadTriangulation(triangulation, "loadTriangulation", "Load the intrinsic triangulation from a file written by --saveTriangulation for the same input mesh, instead of computing it. Supports the intrinsic triangulation outputs only: geometry-central cannot trace a loaded triangulation over the input, so --functionTransferMat, --transferFunction, --commonSubdivision and --commonSubdivisionRegion still need the triangulation to be computed. Implies --noGUI", {"loadTriangulation"});
+  args::ValueFlag<std::string> meshCache(parser, "meshCache", "Directory in which to cache a binary copy of each input mesh, so that later runs on the same file skip parsing it", {"meshCache"});
+
+  args::Group output(parser, "ouput");
+  args::Flag noGUI(output, "noGUI", "exit after processing and do not open the GUI", {"noGUI"});
+  args::ValueFlag<std::string> outputPrefixArg(output, "outputPrefix", "Prefix to prepend to all output file paths. In batch mode, the mesh name is appended to it. Default: intrinsic_", {"outputPrefix"}, "intrinsic_");
+  args::ValueFlag<std::string> outputFormat(output, "outputFormat", "Format for matrix outputs: 'ascii', or 'binary' for memory-mappable files with a '.bin' suffix. Default: ascii", {"outputFormat"}, "ascii");
+  args::Flag intrinsicFaces(output, "edgeLengths", "write the face information for the intrinsic triangulation. name: 'faceInds.dmat, faceLengths.dmat'", {"intrinsicFaces"});
+  args::Flag vertexPositions(output, "vertexPositions", "write the vertex positions for the intrinsic triangulation. name: 'vertexPositions.dmat'", {"vertexPositions"});
+  args::Flag laplaceMat(output, "laplaceMat", "write the Laplace-Beltrami matrix for the triangulation. name: 'laplace.spmat'", {"laplaceMat"});
+  args::Flag massMat(output, "massMat", "write the lumped (diagonal) mass matrix for the triangulation. name: 'mass.spmat'", {"massMat"});
+  args::Flag interpolateMat(output, "interpolateMat", "write the matrix which expresses data on the intrinsic vertices as a linear combination of the input vertices. name: 'interpolate.mat'", {"interpolateMat"});
+  args::ValueFlag<std::string> sampleAttributesFile(output, "sampleAttributes", "sample every column of this dense matrix file (one row per input vertex, one column per attribute channel) at the intrinsic vertices, all channels in one pass. name: 'sampledAttributes.dmat'", {"sampleAttributes"});
+  args::ValueFlag<std::string> heatGeodesic(output, "heatGeodesic", "compute geodesic distance on the intrinsic triangulation by the heat method, from each line of input vertex indices in this file, factoring once for every line. name: 'heatGeodesic.dmat'", {"heatGeodesic"});
+  args::ValueFlag<std::string> poissonSolve(output, "poissonSolve", "solve the Poisson equation L x = b with the intrinsic cotan Laplacian for each column b of this dense matrix file (one row per intrinsic vertex), factoring L once. name: 'poissonSolution.dmat'", {"poissonSolve"});
+  args::Flag functionTransferMat(output, "functionTransferMat", "write the linear systems for L2-optimal function transfer between the input and intrinsic triangulations. name: 'InputToIntrinsic_lhs.spmat', 'InputToIntrinsic_rhs.spmat', etc.", {"functionTransferMat"});
+  args::ValueFlag<std::string> transferFunction(output, "transferFunction", "L2-optimally transfer the functions in this dense matrix file (one per column, one row per source vertex) in the --direction given, factoring the mass matrix once for all of them. name: 'InputToIntrinsic_transferred.dmat' or 'IntrinsicToInput_transferred.dmat'", {"transferFunction"});
+  args::ValueFlag<std::string> direction(output, "direction", "direction of function transfer: 'AtoB' from the input to the intrinsic triangulation, or 'BtoA' back. Required by --transferFunction. Limits --functionTransferMat to that direction. Default: both", {"direction"});
+  args::Flag commonSubdivision(output, "commonSubdivision", "write the common subdivision to an obj file. name: 'common_subdivision.obj', or with --compactCommonSubdivision 'common_subdivision_edges.obj'.", {"commonSubdivision"});
+  args::ValueFlag<int> traceThreads(output, "traceThreads", "trace intrinsic edges over the input mesh on this many threads, for the common subdivision statistics, --commonSubdivisionRegion and the GUI's traced edges. Use 0 for one per hardware thread. Default: trace with geometry-central's serial common subdivision", {"traceThreads"});
+  args::ValueFlag<std::string> compactCommonSubdivision(output, "compactCommonSubdivision", "store the common subdivision's vertices and edges in flat arrays with 32-bit indices ('exact'), or also with 16-bit crossing parameters ('quantized'), without building its mesh. --commonSubdivision then writes its edges as polylines, to 'common_subdivision_edges.obj' instead", {"compactCommonSubdivision"});
+  args::ValueFlag<std::string> commonSubdivisionRegion(output, "commonSubdivisionRegion", "trace the common subdivision only over the faces listed in this file (whitespace-separated face indices), and write its edges as polylines to an obj file. name: 'common_subdivision_region.obj'", {"commonSubdivisionRegion"});
+  args::ValueFlag<std::string> regionFaces(output, "regionFaces", "whether the faces listed for --commonSubdivisionRegion are 'input' or 'intrinsic' faces. Default: input", {"regionFaces"}, "input");
+  args::Flag logStats(output, "logStats", "write performance statistics. name: 'stats.tsv'", {"logStats"});
+  args::ValueFlag<std::string> statsFile(output, "statsFile", "append one row of performance statistics per mesh to this file, shared by every mesh in a batch, instead of writing 'stats.tsv' for each. Implies --logStats", {"statsFile"});
+  args::Flag deterministic(output, "deterministic", "record a content hash of every output file in the statistics, as 'hash/<file>' columns, to check that outputs do not change between runs, machines or thread counts. Implies --logStats", {"deterministic"});
+  // clang-format on
+
+
+  // Parse args
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (const args::Help& h) {
+    std::cout << parser;
+    return 0;
+  } catch (const args::ParseError& e) {
+    std::cerr << e.what() << std::endl;
+    std::cerr << parser;
+    return 1;
+  }
+
+  // Make sure a mesh name was given
+  if (!inputFilename && !batchManifest) {
+    std::cout << parser;
+    return EXIT_FAILURE;
+  }
+
+  if (batchManifest && (saveTriangulation || loadTriangulation)) {
+    std::cout << "Error: --saveTriangulation and --loadTriangulation name a single file, and cannot be used with --batch"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (loadTriangulation && (flipDelaunay || refineDelaunay || saveTriangulation || functionTransferMat ||
+                            transferFunction || commonSubdivision || commonSubdivisionRegion)) {
+    std::cout << "Error: a loaded triangulation cannot be flipped, refined or saved again, and cannot be traced over "
+                 "the input, so it does not support --functionTransferMat, --transferFunction, --commonSubdivision or "
+                 "--commonSubdivisionRegion"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (batchManifest && (transferFunction || sampleAttributesFile || heatGeodesic || poissonSolve)) {
+    std::cout << "Error: --transferFunction, --sampleAttributes, --heatGeodesic and --poissonSolve read values for a "
+                 "single mesh, and cannot be used with --batch"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (transferFunction && !direction) {
+    std::cout << "Error: --transferFunction needs a --direction, 'AtoB' or 'BtoA'" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // A SIGINT (as from the benchmark scripts' timeout) stops flips and refinement in rounds cleanly, so that everything
+  // after them is still logged and written
+  std::signal(SIGINT, handleInterrupt);
+
+  // Set options
+#ifdef INT_TRI_HEADLESS
+  withGUI = false;
+#else
+  withGUI = !noGUI && !batchManifest && !loadTriangulation;
+#endif
+  std::string outputPrefix = args::get(outputPrefixArg);
+
+  ProcessingOptions options;
+  options.refineDegreeThresh = args::get(refineAngle);
+  options.refineToSize = args::get(refineSizeCircum);
+  options.triangulateInput = args::get(triangulateInput);
+  options.meshCache = args::get(meshCache);
+  options.flipDelaunay = args::get(flipDelaunay);
+  options.refineDelaunay = args::get(refineDelaunay);
+  options.refineMaxInsertions = args::get(refineMaxInsertions);
+  try {
+    if (flipTimeBudget) options.flipTimeBudget = parseDuration(args::get(flipTimeBudget));
+    if (refineTimeBudget) options.refineTimeBudget = parseDuration(args::get(refineTimeBudget));
+  } catch (const std::exception& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  options.reportProgress = args::get(progress);
+  options.saveTriangulation = args::get(saveTriangulation);
+  options.loadTriangulation = args::get(loadTriangulation);
+  options.intrinsicFaces = args::get(intrinsicFaces);
+  options.vertexPositions = args::get(vertexPositions);
+  options.laplaceMat = args::get(laplaceMat);
+  options.massMat = args::get(massMat);
+  options.interpolateMat = args::get(interpolateMat);
+  options.functionTransferMat = args::get(functionTransferMat);
+  options.transferFunction = args::get(transferFunction);
+  options.sampleAttributes = args::get(sampleAttributesFile);
+  options.heatGeodesic = args::get(heatGeodesic);
+  options.poissonSolve = args::get(poissonSolve);
+  if (direction) {
+    if (args::get(direction) != "AtoB" && args::get(direction) != "BtoA") {
+      std::cout << "Error: unrecognized transfer direction '" << args::get(direction) << "'. Please use 'AtoB' or 'BtoA'"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    options.transferToIntrinsic = args::get(direction) == "AtoB";
+    options.transferToInput = args::get(direction) == "BtoA";
+  }
+  options.commonSubdivision = args::get(commonSubdivision);
+  options.commonSubdivisionRegion = args::get(commonSubdivisionRegion);
+  if (traceThreads) options.traceThreads = std::max(0, args::get(traceThreads));
+  if (compactCommonSubdivision) {
+    options.compactCommonSubdivision = args::get(compactCommonSubdivision);
+    if (options.compactCommonSubdivision != "exact" && options.compactCommonSubdivision != "quantized") {
+      std::cout << "Error: unrecognized compact common subdivision mode '" << options.compactCommonSubdivision
+                << "'. Please use 'exact' or 'quantized'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (args::get(regionFaces) == "input" || args::get(regionFaces) == "intrinsic") {
+    options.regionOnInput = args::get(regionFaces) == "input";
+  } else {
+    std::cout << "Error: unrecognized region face type '" << args::get(regionFaces)
+              << "'. Please use 'input' or 'intrinsic'" << std::endl;
+    return EXIT_FAILURE;
+  }
+  options.deterministic = args::get(deterministic);
+  options.logStats = args::get(logStats) || statsFile || options.deterministic;
+
+  try {
+    options.outputFormat = matrixFormatFromString(args::get(outputFormat));
+  } catch (const std::runtime_error& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (backendFlag) {
+    if (args::get(backendFlag) == "signpost") {
+      options.backend = "Signposts";
+    } else if (args::get(backendFlag) == "integer") {
+      options.backend = "Integer Coordinates";
+    } else if (args::get(backendFlag) == "auto" || args::get(backendFlag) == "both") {
+      options.backend = args::get(backendFlag);
+    } else {
+      std::cout << "Error: unrecognized backend '" << args::get(backendFlag)
+                << "'. Please use 'signpost', 'integer', 'auto' or 'both'" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::unique_ptr<TsvLogStream> statsStream;
+  if (statsFile) {
+    try {
+      statsStream.reset(new TsvLogStream(args::get(statsFile)));
+    } catch (const std::runtime_error& e) {
+      std::cout << "Error: " << e.what() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (batchManifest) {
+    std::vector<BatchEntry> entries;
+    if (args::get(batchManifest) == "-") {
+      entries = readBatchManifest(std::cin, outputPrefix);
+    } else {
+      std::ifstream manifest(args::get(batchManifest));
+      if (!manifest.is_open()) {
+        std::cout << "Error: failed to open batch manifest " << args::get(batchManifest) << std::endl;
+        return EXIT_FAILURE;
+      }
+      entries = readBatchManifest(manifest, outputPrefix);
+    }
+    if (inputFilename) {
+      entries.insert(entries.begin(),
+                     BatchEntry{args::get(inputFilename),
+                                outputPrefix + meshNameFromPath(args::get(inputFilename)) + "_"});
+    }
+
+    size_t nThreads = args::get(threads) > 0 ? args::get(threads) : std::max(1u, std::thread::hardware_concurrency());
+    size_t nFailed = processBatch(entries, options, nThreads, statsStream.get());
+    return nFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
 
-  if (logStats) writeLog(logger, outputPrefix);
+  guiContext.outputPrefix = outputPrefix;
+  guiContext.statsStream = statsStream.get();
+  processMesh(guiContext, args::get(inputFilename), options);
+  if (statsStream) statsStream->close();
 
+#ifndef INT_TRI_HEADLESS
   // Give control to the polyscope gui
   if (withGUI) {
     polyscope::show();
   }
+#endif
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,49 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string filename) {
+#ifndef _WIN32
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, info.st_size, MADV_SEQUENTIAL);
+        begin = static_cast<const char*>(addr);
+        length = info.st_size;
+        mapped = true;
+      }
+    }
+    close(fd);
+    if (mapped) return;
+  }
+#endif
+
+  // Fall back on reading the whole file
+  std::ifstream in(filename, std::ios::binary);
+  if (!in.is_open()) {
+    throw std::runtime_error("failed to open file " + filename);
+  }
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  buffer = contents.str();
+  begin = buffer.data();
+  length = buffer.size();
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (mapped) munmap(const_cast<char*>(begin), length);
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A read-only view of a whole file. The file is memory-mapped where the platform supports it, and read into memory
+// otherwise. Throws if the file cannot be opened.
+class MappedFile {
+public:
+  MappedFile(std::string filename);
+  ~MappedFile();
+
+  const char* data() const { return begin; }
+  size_t size() const { return length; }
+
+private:
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* begin = nullptr;
+  size_t length = 0;
+  bool mapped = false;
+  std::string buffer; // contents of the file, if it could not be mapped
+};
@@ -0,0 +1,291 @@
+#include "matrix_io.h"
+
+#include "mapped_file.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+MatrixFormat matrixFormatFromString(std::string name) {
+  if (name == "ascii") return MatrixFormat::ASCII;
+  if (name == "binary") return MatrixFormat::Binary;
+  throw std::runtime_error("unrecognized output format '" + name + "'. Please use 'ascii' or 'binary'");
+}
+
+std::string matrixFormatSuffix(MatrixFormat format) {
+  switch (format) {
+  case MatrixFormat::ASCII:
+    return "";
+  case MatrixFormat::Binary:
+    return ".bin";
+  }
+  return "";
+}
+
+namespace {
+
+enum class BinaryValueType : uint32_t { Float64 = 0, Int64 = 1, UInt64 = 2 };
+enum class BinaryKind : uint32_t { Dense = 0, Sparse = 1 };
+
+template <typename T>
+BinaryValueType binaryValueType();
+template <>
+BinaryValueType binaryValueType<double>() {
+  return BinaryValueType::Float64;
+}
+template <>
+BinaryValueType binaryValueType<size_t>() {
+  static_assert(sizeof(size_t) == 8, "binary matrix output assumes 64-bit size_t");
+  return BinaryValueType::UInt64;
+}
+
+bool hostIsLittleEndian() {
+  const uint16_t probe = 1;
+  unsigned char firstByte;
+  std::memcpy(&firstByte, &probe, 1);
+  return firstByte == 1;
+}
+
+// Appends fixed-size values to a buffer in little-endian byte order, byte-swapping on big-endian hosts
+class LittleEndianEncoder {
+public:
+  LittleEndianEncoder(std::string& out_) : out(out_), swap(!hostIsLittleEndian()) {}
+
+  template <typename T>
+  void write(T val) {
+    writeArray(&val, 1);
+  }
+
+  template <typename T>
+  void writeArray(const T* data, size_t n) {
+    if (!swap) {
+      out.append(reinterpret_cast<const char*>(data), n * sizeof(T));
+    } else {
+      char bytes[sizeof(T)];
+      for (size_t i = 0; i < n; i++) {
+        std::memcpy(bytes, &data[i], sizeof(T));
+        for (size_t b = 0; b < sizeof(T) / 2; b++) std::swap(bytes[b], bytes[sizeof(T) - 1 - b]);
+        out.append(bytes, sizeof(T));
+      }
+    }
+  }
+
+  void writeHeader(BinaryKind kind, BinaryValueType valueType, bool colMajor, size_t rows, size_t cols,
+                   size_t nValues) {
+    out.append("ITMATRIX", 8);
+    write<uint32_t>(1);
+    write<uint32_t>(static_cast<uint32_t>(kind));
+    write<uint32_t>(static_cast<uint32_t>(valueType));
+    write<uint32_t>(colMajor ? 1 : 0);
+    write<uint64_t>(rows);
+    write<uint64_t>(cols);
+    write<uint64_t>(nValues);
+  }
+
+private:
+  std::string& out;
+  bool swap;
+};
+
+// Reads a fixed-size little-endian value, byte-swapping on big-endian hosts
+template <typename T>
+T readLittleEndian(const char* data) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, data, sizeof(T));
+  if (!hostIsLittleEndian()) {
+    for (size_t b = 0; b < sizeof(T) / 2; b++) std::swap(bytes[b], bytes[sizeof(T) - 1 - b]);
+  }
+  T val;
+  std::memcpy(&val, bytes, sizeof(T));
+  return val;
+}
+
+void writeWholeFile(std::string filename, const std::string& contents) {
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    throw std::runtime_error("failed to open output file " + filename);
+  }
+  out.write(contents.data(), contents.size());
+  out.close();
+  if (out.fail()) {
+    throw std::runtime_error("failed to write output file " + filename);
+  }
+}
+
+// Formats values the same way as an ostream with precision 16
+void appendAscii(std::string& out, double val) {
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%.16g", val);
+  out.append(buf, n);
+}
+void appendAscii(std::string& out, size_t val) {
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%zu", val);
+  out.append(buf, n);
+}
+
+} // namespace
+
+template <typename T>
+std::string encodeDenseMatrix(MatrixFormat format, const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matrix) {
+  size_t rows = matrix.rows();
+  size_t cols = matrix.cols();
+  std::string out;
+
+  if (format == MatrixFormat::ASCII) {
+    out += "# dense " + std::to_string(rows) + " " + std::to_string(cols) + "\n";
+    for (size_t iR = 0; iR < rows; iR++) {
+      for (size_t iC = 0; iC < cols; iC++) {
+        if (iC > 0) out += ' ';
+        appendAscii(out, matrix(iR, iC));
+      }
+      out += '\n';
+    }
+    return out;
+  }
+
+  out.reserve(BINARY_MATRIX_HEADER_SIZE + rows * cols * sizeof(T));
+  LittleEndianEncoder encoder(out);
+  encoder.writeHeader(BinaryKind::Dense, binaryValueType<T>(), false, rows, cols, rows * cols);
+
+  // Eigen stores dense matrices column-major, so transpose one row at a time
+  std::vector<T> row(cols);
+  for (size_t iR = 0; iR < rows; iR++) {
+    for (size_t iC = 0; iC < cols; iC++) row[iC] = matrix(iR, iC);
+    encoder.writeArray(row.data(), cols);
+  }
+  return out;
+}
+
+template <typename T, int Options>
+std::string encodeSparseMatrix(MatrixFormat format, const Eigen::SparseMatrix<T, Options>& matrix) {
+  if (format == MatrixFormat::ASCII) {
+    // Entries are listed column by column, with 1-indexed rows and columns
+    Eigen::SparseMatrix<T, Eigen::ColMajor> colMajor = matrix;
+    std::string out = "# sparse " + std::to_string(colMajor.rows()) + " " + std::to_string(colMajor.cols()) + "\n";
+    for (int k = 0; k < colMajor.outerSize(); k++) {
+      for (typename Eigen::SparseMatrix<T, Eigen::ColMajor>::InnerIterator it(colMajor, k); it; ++it) {
+        appendAscii(out, (size_t)it.row() + 1);
+        out += ' ';
+        appendAscii(out, (size_t)it.col() + 1);
+        out += ' ';
+        appendAscii(out, it.value());
+        out += '\n';
+      }
+    }
+    return out;
+  }
+
+  if (!matrix.isCompressed()) {
+    Eigen::SparseMatrix<T, Options> compressed = matrix;
+    compressed.makeCompressed();
+    return encodeSparseMatrix(format, compressed);
+  }
+
+  size_t nnz = matrix.nonZeros();
+  size_t outerSize = matrix.outerSize();
+  std::string out;
+  out.reserve(BINARY_MATRIX_HEADER_SIZE + (outerSize + 1 + nnz) * sizeof(int64_t) + nnz * sizeof(T));
+  LittleEndianEncoder encoder(out);
+  bool colMajor = !(Options & Eigen::RowMajor);
+  encoder.writeHeader(BinaryKind::Sparse, binaryValueType<T>(), colMajor, matrix.rows(), matrix.cols(), nnz);
+
+  // Eigen's storage index is usually a 32-bit int; widen the index arrays to int64
+  std::vector<int64_t> outer(matrix.outerIndexPtr(), matrix.outerIndexPtr() + outerSize + 1);
+  std::vector<int64_t> inner(matrix.innerIndexPtr(), matrix.innerIndexPtr() + nnz);
+  encoder.writeArray(outer.data(), outer.size());
+  encoder.writeArray(inner.data(), inner.size());
+  encoder.writeArray(matrix.valuePtr(), nnz);
+  return out;
+}
+
+template <typename T>
+void saveDenseMatrixBinary(std::string filename, const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matrix) {
+  writeWholeFile(filename, encodeDenseMatrix(MatrixFormat::Binary, matrix));
+}
+
+template <typename T, int Options>
+void saveSparseMatrixBinary(std::string filename, const Eigen::SparseMatrix<T, Options>& matrix) {
+  writeWholeFile(filename, encodeSparseMatrix(MatrixFormat::Binary, matrix));
+}
+
+// clang-format off
+template void saveDenseMatrixBinary(std::string filename, const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+template void saveDenseMatrixBinary(std::string filename, const Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+template void saveSparseMatrixBinary(std::string filename, const Eigen::SparseMatrix<double, Eigen::ColMajor>& matrix);
+template void saveSparseMatrixBinary(std::string filename, const Eigen::SparseMatrix<double, Eigen::RowMajor>& matrix);
+template std::string encodeDenseMatrix(MatrixFormat format, const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+template std::string encodeDenseMatrix(MatrixFormat format, const Eigen::Matrix<size_t, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+template std::string encodeSparseMatrix(MatrixFormat format, const Eigen::SparseMatrix<double, Eigen::ColMajor>& matrix);
+template std::string encodeSparseMatrix(MatrixFormat format, const Eigen::SparseMatrix<double, Eigen::RowMajor>& matrix);
+// clang-format on
+
+Eigen::MatrixXd loadDenseMatrix(std::string filename) {
+  MappedFile file(filename);
+  const char* data = file.data();
+  auto invalid = [&](std::string reason) {
+    return std::runtime_error("invalid dense matrix file " + filename + ": " + reason);
+  };
+
+  if (file.size() >= BINARY_MATRIX_HEADER_SIZE && std::memcmp(data, "ITMATRIX", 8) == 0) {
+    uint32_t version = readLittleEndian<uint32_t>(data + 8);
+    BinaryKind kind = static_cast<BinaryKind>(readLittleEndian<uint32_t>(data + 12));
+    BinaryValueType valueType = static_cast<BinaryValueType>(readLittleEndian<uint32_t>(data + 16));
+    uint64_t rows = readLittleEndian<uint64_t>(data + 24);
+    uint64_t cols = readLittleEndian<uint64_t>(data + 32);
+    if (version != 1) throw invalid("unsupported version " + std::to_string(version));
+    if (kind != BinaryKind::Dense) throw invalid("not a dense matrix");
+    if (readLittleEndian<uint64_t>(data + 40) != rows * cols ||
+        file.size() != BINARY_MATRIX_HEADER_SIZE + rows * cols * sizeof(double)) {
+      throw invalid("wrong size");
+    }
+
+    // Dense values are stored row-major
+    Eigen::MatrixXd matrix(rows, cols);
+    const char* values = data + BINARY_MATRIX_HEADER_SIZE;
+    for (size_t iR = 0; iR < rows; iR++) {
+      for (size_t iC = 0; iC < cols; iC++) {
+        const char* val = values + (iR * cols + iC) * sizeof(double);
+        switch (valueType) {
+        case BinaryValueType::Float64:
+          matrix(iR, iC) = readLittleEndian<double>(val);
+          break;
+        case BinaryValueType::Int64:
+          matrix(iR, iC) = readLittleEndian<int64_t>(val);
+          break;
+        case BinaryValueType::UInt64:
+          matrix(iR, iC) = readLittleEndian<uint64_t>(val);
+          break;
+        default:
+          throw invalid("unknown value type");
+        }
+      }
+    }
+    return matrix;
+  }
+
+  // The ASCII format is a "# dense <rows> <cols>" line followed by the values, one row per line. Parsing runs over a
+  // copy of the file, so that strtod() stops at its terminating null.
+  std::string contents(data, file.size());
+  if (contents.compare(0, 8, "# dense ") != 0) throw invalid("not a dense matrix");
+  const char* pos = contents.c_str() + 8;
+  char* rowsEnd;
+  char* end;
+  unsigned long long rows = std::strtoull(pos, &rowsEnd, 10);
+  unsigned long long cols = std::strtoull(rowsEnd, &end, 10);
+  if (rowsEnd == pos || end == rowsEnd) throw invalid("missing dimensions");
+
+  Eigen::MatrixXd matrix(rows, cols);
+  pos = end;
+  for (size_t iR = 0; iR < rows; iR++) {
+    for (size_t iC = 0; iC < cols; iC++) {
+      matrix(iR, iC) = std::strtod(pos, &end);
+      if (end == pos) throw invalid("expected " + std::to_string(rows * cols) + " values");
+      pos = end;
+    }
+  }
+  return matrix;
+}
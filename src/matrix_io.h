@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <cstdint>
+#include <string>
+
+// Formats for writing dense and sparse matrices
+enum class MatrixFormat { ASCII, Binary };
+
+// Parse "ascii" or "binary", throwing on anything else
+MatrixFormat matrixFormatFromString(std::string name);
+
+// Suffix appended to output filenames in the given format
+std::string matrixFormatSuffix(MatrixFormat format);
+
+// == Binary matrix files
+//
+// A binary matrix file is a fixed 48 byte header followed by raw little-endian arrays, each starting at an 8 byte
+// aligned offset, so that the file can be memory-mapped and the arrays used in place.
+//
+//   offset  size  field
+//        0     8  magic "ITMATRIX"
+//        8     4  uint32 format version (currently 1)
+//       12     4  uint32 kind: 0 = dense, 1 = sparse
+//       16     4  uint32 value type: 0 = float64, 1 = int64, 2 = uint64
+//       20     4  uint32 storage order: 0 = row-major (CSR for sparse), 1 = column-major (CSC for sparse)
+//       24     8  uint64 rows
+//       32     8  uint64 cols
+//       40     8  uint64 number of stored values (rows * cols for dense matrices)
+//
+// Dense matrices are followed by rows * cols values in row-major order. Sparse matrices are followed by their
+// compressed `outer` index array (outerSize + 1 int64 entries, where outerSize is the number of columns for CSC and
+// rows for CSR), their `inner` index array (nnz int64 entries) and finally their values (nnz entries). Indices are
+// 0-indexed.
+
+const size_t BINARY_MATRIX_HEADER_SIZE = 48;
+
+// These are instantiated for double and size_t dense matrices, and double sparse matrices in either storage order
+template <typename T>
+void saveDenseMatrixBinary(std::string filename, const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+
+template <typename T, int Options>
+void saveSparseMatrixBinary(std::string filename, const Eigen::SparseMatrix<T, Options>& matrix);
+
+// Encode a matrix in memory, exactly as it would be written to a file in the given format. The ASCII encoding matches
+// geometry-central's saveDenseMatrix()/saveSparseMatrix(). Instantiated for the same types as the binary writers.
+template <typename T>
+std::string encodeDenseMatrix(MatrixFormat format, const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>& matrix);
+
+template <typename T, int Options>
+std::string encodeSparseMatrix(MatrixFormat format, const Eigen::SparseMatrix<T, Options>& matrix);
+
+// Read a dense matrix of doubles written in either format, which is detected from the file's contents. Values in
+// binary files with an integer value type are converted to doubles. Throws if the file cannot be read or is malformed.
+Eigen::MatrixXd loadDenseMatrix(std::string filename);
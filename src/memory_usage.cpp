@@ -0,0 +1,105 @@
+#include "memory_usage.h"
+
+#include "geometrycentral/surface/common_subdivision.h"
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/normal_coordinates.h"
+#include "geometrycentral/surface/surface_mesh.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#include <time.h>
+#else
+#include <fstream>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+size_t currentResidentSetBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+  mach_task_basic_info info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+  return info.resident_size;
+#else
+  // The second field of statm is the number of resident pages
+  std::ifstream statm("/proc/self/statm");
+  size_t totalPages, residentPages;
+  if (!(statm >> totalPages >> residentPages)) return 0;
+  return residentPages * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+size_t peakResidentSetBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss; // bytes on macOS
+#else
+  return usage.ru_maxrss * 1024; // kilobytes on Linux
+#endif
+#endif
+}
+
+double threadCpuSeconds() {
+#if defined(_WIN32)
+  // Kernel and user times, in units of 100ns
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return -1;
+  auto ticks = [](const FILETIME& t) { return ((unsigned long long)t.dwHighDateTime << 32) | t.dwLowDateTime; };
+  return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+  struct timespec t;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0) return -1;
+  return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+size_t meshConnectivityBytes(SurfaceMesh& mesh) {
+  // next, vertex and face for each halfedge, plus one halfedge for each vertex and face. Twins and edges are implicit
+  // in a manifold mesh.
+  return sizeof(size_t) * (3 * mesh.nHalfedgesCapacity() + mesh.nVerticesCapacity() + mesh.nFacesCapacity());
+}
+
+size_t intrinsicTriangulationBytes(IntrinsicTriangulation& intTri) {
+  size_t bytes = meshConnectivityBytes(*intTri.intrinsicMesh);
+  bytes += intTri.intrinsicEdgeLengths.size() * sizeof(double);
+  bytes += intTri.vertexLocations.size() * sizeof(SurfacePoint);
+  return bytes;
+}
+
+size_t normalCoordinatesBytes(const NormalCoordinates& coords) {
+  return sizeof(int) * (coords.edgeCoords.size() + coords.roundabouts.size() + coords.roundaboutDegrees.size());
+}
+
+size_t commonSubdivisionBytes(CommonSubdivision& cs) {
+  size_t bytes = cs.subdivisionPoints.size() * sizeof(CommonSubdivisionPoint);
+  for (Edge e : cs.meshB.edges()) {
+    bytes += sizeof(std::vector<CommonSubdivisionPoint*>);
+    bytes += cs.pointsAlongB[e].capacity() * sizeof(CommonSubdivisionPoint*);
+  }
+  if (cs.mesh) {
+    bytes += meshConnectivityBytes(*cs.mesh);
+    bytes += cs.sourcePoints.size() * sizeof(CommonSubdivisionPoint*);
+    bytes += (cs.sourceFaceA.size() + cs.sourceFaceB.size()) * sizeof(Face);
+  }
+  return bytes;
+}
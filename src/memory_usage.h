@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+namespace geometrycentral {
+namespace surface {
+class SurfaceMesh;
+class IntrinsicTriangulation;
+class NormalCoordinates;
+class CommonSubdivision;
+} // namespace surface
+} // namespace geometrycentral
+
+// == Process memory
+// Both are for the whole process, so they include every mesh being processed concurrently in batch mode. They return
+// 0 on platforms where the value is not available.
+
+// Current resident set size, in bytes
+size_t currentResidentSetBytes();
+
+// Largest resident set size over the lifetime of the process, in bytes
+size_t peakResidentSetBytes();
+
+const double BYTES_PER_MB = 1024. * 1024.;
+
+// == Thread CPU time
+
+// CPU time used so far by the calling thread alone, in seconds, or -1 on platforms where it is not available. Unlike
+// std::clock(), this does not count other threads, such as other meshes processed concurrently in batch mode.
+double threadCpuSeconds();
+
+// == Data structure sizes
+// Approximate heap usage of geometry-central's data structures, estimated from their element counts and capacities
+// rather than measured, so allocator overhead is not included.
+
+// Connectivity arrays of a halfedge mesh
+size_t meshConnectivityBytes(geometrycentral::surface::SurfaceMesh& mesh);
+
+// Intrinsic mesh connectivity, edge lengths and vertex locations of an intrinsic triangulation, not including any
+// backend-specific data
+size_t intrinsicTriangulationBytes(geometrycentral::surface::IntrinsicTriangulation& intTri);
+
+// Normal coordinates and roundabouts of an integer coordinates triangulation
+size_t normalCoordinatesBytes(const geometrycentral::surface::NormalCoordinates& coords);
+
+// Subdivision points, their lists along each intrinsic edge, and the extracted mesh if it has been constructed
+size_t commonSubdivisionBytes(geometrycentral::surface::CommonSubdivision& cs);
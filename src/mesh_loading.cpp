@@ -0,0 +1,816 @@
+#include "mesh_loading.h"
+
+#include "geometrycentral/surface/simple_polygon_mesh.h"
+#include "geometrycentral/surface/surface_mesh_factories.h"
+
+#include "async_writer.h"
+#include "content_hash.h"
+#include "mapped_file.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <process.h> // _getpid
+#else
+#include <unistd.h> // getpid
+#endif
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+namespace {
+
+typedef std::vector<std::vector<std::tuple<size_t, size_t>>> TwinList;
+
+struct PolygonSoup {
+  std::vector<Vector3> positions;
+  std::vector<std::vector<size_t>> polygons;
+};
+
+// Thrown by the parsers below for files they do not handle, which are then read by geometry-central instead
+class UnsupportedFile : public std::runtime_error {
+public:
+  UnsupportedFile(std::string msg) : std::runtime_error(msg) {}
+};
+
+// == Text parsing
+// The parsers work directly on the mapped file, which is not null-terminated, so every helper takes an end pointer.
+
+const char* skipSpaces(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+  return p;
+}
+
+const char* findLineEnd(const char* p, const char* end) {
+  const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+  return newline ? newline : end;
+}
+
+const char* tokenEnd(const char* p, const char* end) {
+  while (p < end && !std::isspace(static_cast<unsigned char>(*p))) p++;
+  return p;
+}
+
+// Parse a number at p, advancing p past it. Returns false if there is no number there.
+bool parseDouble(const char*& p, const char* end, double& val) {
+  p = skipSpaces(p, end);
+  const char* tokEnd = tokenEnd(p, end);
+  char buf[64];
+  size_t len = std::min<size_t>(tokEnd - p, sizeof(buf) - 1);
+  if (len == 0) return false;
+  std::memcpy(buf, p, len);
+  buf[len] = '\0';
+  char* parsedEnd;
+  val = std::strtod(buf, &parsedEnd);
+  if (parsedEnd == buf) return false;
+  p = tokEnd;
+  return true;
+}
+
+bool parseInteger(const char*& p, const char* end, long long& val) {
+  p = skipSpaces(p, end);
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  if (p == end || !std::isdigit(static_cast<unsigned char>(*p))) return false;
+  val = 0;
+  while (p < end && std::isdigit(static_cast<unsigned char>(*p))) val = 10 * val + (*p++ - '0');
+  if (negative) val = -val;
+  return true;
+}
+
+// Split [begin, end) into up to nChunks pieces, each ending just after a newline
+std::vector<const char*> splitLines(const char* begin, const char* end, size_t nChunks) {
+  std::vector<const char*> bounds = {begin};
+  for (size_t iC = 1; iC < nChunks; iC++) {
+    const char* p = std::max(bounds.back(), begin + (end - begin) * iC / nChunks);
+    p = findLineEnd(p, end);
+    if (p < end) p++;
+    if (p > bounds.back() && p < end) bounds.push_back(p);
+  }
+  bounds.push_back(end);
+  return bounds;
+}
+
+size_t parseChunkCount(size_t nThreads) { return 4 * resolveThreadCount(nThreads); }
+
+// == OBJ
+
+bool isObjLine(const char* p, const char* end, char type) {
+  return p + 1 < end && p[0] == type && (p[1] == ' ' || p[1] == '\t');
+}
+
+// Two passes over the file in parallel chunks: the first counts the vertex and face lines in each chunk, which gives
+// every chunk the index of its first vertex and face, and the second parses each chunk straight into place
+PolygonSoup parseObj(const MappedFile& file, size_t nThreads) {
+  const char* fileEnd = file.data() + file.size();
+  std::vector<const char*> chunks = splitLines(file.data(), fileEnd, parseChunkCount(nThreads));
+  size_t nChunks = chunks.size() - 1;
+
+  std::vector<size_t> vertexStart(nChunks + 1, 0), faceStart(nChunks + 1, 0);
+  parallelFor(
+      nChunks,
+      [&](size_t iC) {
+        for (const char* line = chunks[iC]; line < chunks[iC + 1];) {
+          const char* end = findLineEnd(line, chunks[iC + 1]);
+          const char* p = skipSpaces(line, end);
+          if (isObjLine(p, end, 'v')) vertexStart[iC + 1]++;
+          if (isObjLine(p, end, 'f')) faceStart[iC + 1]++;
+          line = end + 1;
+        }
+      },
+      nThreads, 1);
+  for (size_t iC = 0; iC < nChunks; iC++) {
+    vertexStart[iC + 1] += vertexStart[iC];
+    faceStart[iC + 1] += faceStart[iC];
+  }
+
+  PolygonSoup soup;
+  size_t nVertices = vertexStart[nChunks];
+  soup.positions.resize(nVertices);
+  soup.polygons.resize(faceStart[nChunks]);
+
+  parallelFor(
+      nChunks,
+      [&](size_t iC) {
+        size_t iV = vertexStart[iC];
+        size_t iF = faceStart[iC];
+        for (const char* line = chunks[iC]; line < chunks[iC + 1];) {
+          const char* end = findLineEnd(line, chunks[iC + 1]);
+          const char* p = skipSpaces(line, end);
+
+          if (isObjLine(p, end, 'v')) {
+            p++;
+            Vector3& pos = soup.positions[iV++];
+            if (!parseDouble(p, end, pos.x) || !parseDouble(p, end, pos.y) || !parseDouble(p, end, pos.z)) {
+              throw std::runtime_error("malformed vertex in obj file: " + std::string(line, end));
+            }
+          } else if (isObjLine(p, end, 'f')) {
+            p++;
+            std::vector<size_t>& poly = soup.polygons[iF++];
+            long long ind;
+            while (parseInteger(p, end, ind)) {
+              // Indices are 1-based, or negative to count back from the most recent vertex
+              long long resolved = ind > 0 ? ind - 1 : (long long)iV + ind;
+              if (ind == 0 || resolved < 0 || resolved >= (long long)nVertices) {
+                throw std::runtime_error("invalid vertex index in obj file: " + std::string(line, end));
+              }
+              poly.push_back(resolved);
+              p = tokenEnd(p, end); // skip any texture coordinate and normal indices
+            }
+          }
+          line = end + 1;
+        }
+      },
+      nThreads, 1);
+
+  return soup;
+}
+
+// == PLY
+
+enum class PlyFormat { ASCII, BinaryLittleEndian, BinaryBigEndian };
+
+struct PlyType {
+  size_t size;
+  bool isFloat;
+  bool isSigned;
+};
+
+PlyType plyType(std::string name) {
+  if (name == "char" || name == "int8") return PlyType{1, false, true};
+  if (name == "uchar" || name == "uint8") return PlyType{1, false, false};
+  if (name == "short" || name == "int16") return PlyType{2, false, true};
+  if (name == "ushort" || name == "uint16") return PlyType{2, false, false};
+  if (name == "int" || name == "int32") return PlyType{4, false, true};
+  if (name == "uint" || name == "uint32") return PlyType{4, false, false};
+  if (name == "float" || name == "float32") return PlyType{4, true, true};
+  if (name == "double" || name == "float64") return PlyType{8, true, true};
+  throw UnsupportedFile("unrecognized ply type " + name);
+}
+
+struct PlyProperty {
+  std::string name;
+  bool isList;
+  PlyType countType; // only for lists
+  PlyType valueType;
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count;
+  std::vector<PlyProperty> properties;
+};
+
+struct PlyHeader {
+  PlyFormat format;
+  std::vector<PlyElement> elements;
+  size_t bodyStart;
+};
+
+PlyHeader parsePlyHeader(const MappedFile& file) {
+  const char* fileEnd = file.data() + file.size();
+  PlyHeader header;
+  bool haveFormat = false;
+
+  const char* line = file.data();
+  while (true) {
+    if (line >= fileEnd) throw std::runtime_error("ply header has no end_header");
+    const char* end = findLineEnd(line, fileEnd);
+    std::istringstream words(std::string(line, end));
+    line = end + 1;
+
+    std::string keyword;
+    words >> keyword;
+    if (keyword == "end_header") break;
+    if (keyword == "format") {
+      std::string format;
+      words >> format;
+      if (format == "ascii") header.format = PlyFormat::ASCII;
+      else if (format == "binary_little_endian") header.format = PlyFormat::BinaryLittleEndian;
+      else if (format == "binary_big_endian") header.format = PlyFormat::BinaryBigEndian;
+      else throw UnsupportedFile("unrecognized ply format " + format);
+      haveFormat = true;
+    } else if (keyword == "element") {
+      PlyElement element;
+      words >> element.name >> element.count;
+      header.elements.push_back(element);
+    } else if (keyword == "property") {
+      if (header.elements.empty()) throw std::runtime_error("ply property before any element");
+      PlyProperty property;
+      property.countType = PlyType{0, false, false};
+      std::string type;
+      words >> type;
+      property.isList = type == "list";
+      if (property.isList) {
+        std::string countType, valueType;
+        words >> countType >> valueType;
+        property.countType = plyType(countType);
+        property.valueType = plyType(valueType);
+      } else {
+        property.valueType = plyType(type);
+      }
+      words >> property.name;
+      header.elements.back().properties.push_back(property);
+    }
+  }
+
+  if (!haveFormat) throw std::runtime_error("ply header has no format");
+  header.bodyStart = line - file.data();
+
+  // Only the common layout of vertices followed by faces is handled here
+  if (header.elements.size() < 2 || header.elements[0].name != "vertex" || header.elements[1].name != "face") {
+    throw UnsupportedFile("ply elements other than vertices followed by faces");
+  }
+  for (const PlyProperty& property : header.elements[0].properties) {
+    if (property.isList) throw UnsupportedFile("ply vertex list property");
+  }
+  return header;
+}
+
+// Index of the property with one of the given names, or -1
+long findPlyProperty(const PlyElement& element, std::vector<std::string> names) {
+  for (size_t iP = 0; iP < element.properties.size(); iP++) {
+    if (std::find(names.begin(), names.end(), element.properties[iP].name) != names.end()) return iP;
+  }
+  return -1;
+}
+
+double readBinaryValue(const char* p, PlyType type, bool swap) {
+  unsigned char bytes[8];
+  std::memcpy(bytes, p, type.size);
+  if (swap) std::reverse(bytes, bytes + type.size);
+
+  if (type.isFloat) {
+    if (type.size == 4) {
+      float val;
+      std::memcpy(&val, bytes, 4);
+      return val;
+    }
+    double val;
+    std::memcpy(&val, bytes, 8);
+    return val;
+  }
+
+  switch (type.size) {
+  case 1:
+    return type.isSigned ? (double)(int8_t)bytes[0] : (double)bytes[0];
+  case 2: {
+    uint16_t val;
+    std::memcpy(&val, bytes, 2);
+    return type.isSigned ? (double)(int16_t)val : (double)val;
+  }
+  default: {
+    uint32_t val;
+    std::memcpy(&val, bytes, 4);
+    return type.isSigned ? (double)(int32_t)val : (double)val;
+  }
+  }
+}
+
+bool hostIsLittleEndian() {
+  const uint16_t probe = 1;
+  unsigned char firstByte;
+  std::memcpy(&firstByte, &probe, 1);
+  return firstByte == 1;
+}
+
+PolygonSoup parsePly(const MappedFile& file, size_t nThreads) {
+  PlyHeader header = parsePlyHeader(file);
+  const PlyElement& vertexElement = header.elements[0];
+  const PlyElement& faceElement = header.elements[1];
+
+  long iX = findPlyProperty(vertexElement, {"x"});
+  long iY = findPlyProperty(vertexElement, {"y"});
+  long iZ = findPlyProperty(vertexElement, {"z"});
+  long iIndices = findPlyProperty(faceElement, {"vertex_indices", "vertex_index"});
+  if (iX < 0 || iY < 0 || iZ < 0 || iIndices < 0 || !faceElement.properties[iIndices].isList) {
+    throw UnsupportedFile("ply file without vertex positions and face indices");
+  }
+
+  PolygonSoup soup;
+  size_t nVertices = vertexElement.count;
+  size_t nFaces = faceElement.count;
+  soup.positions.resize(nVertices);
+  soup.polygons.resize(nFaces);
+
+  auto checkIndex = [&](double ind) {
+    if (ind < 0 || ind >= nVertices) throw std::runtime_error("invalid vertex index in ply file");
+    return (size_t)ind;
+  };
+
+  const char* body = file.data() + header.bodyStart;
+  const char* fileEnd = file.data() + file.size();
+
+  if (header.format == PlyFormat::ASCII) {
+    // Count the lines in each chunk, so that each one knows which vertex or face its lines hold
+    std::vector<const char*> chunks = splitLines(body, fileEnd, parseChunkCount(nThreads));
+    size_t nChunks = chunks.size() - 1;
+    std::vector<size_t> lineStart(nChunks + 1, 0);
+    parallelFor(
+        nChunks, [&](size_t iC) { lineStart[iC + 1] = std::count(chunks[iC], chunks[iC + 1], '\n'); }, nThreads, 1);
+    for (size_t iC = 0; iC < nChunks; iC++) lineStart[iC + 1] += lineStart[iC];
+    if (lineStart[nChunks] + 1 < nVertices + nFaces) throw std::runtime_error("ply file is truncated");
+
+    parallelFor(
+        nChunks,
+        [&](size_t iC) {
+          size_t iLine = lineStart[iC];
+          for (const char* line = chunks[iC]; line < chunks[iC + 1] && iLine < nVertices + nFaces; iLine++) {
+            const char* end = findLineEnd(line, chunks[iC + 1]);
+            const char* p = line;
+            const PlyElement& element = iLine < nVertices ? vertexElement : faceElement;
+            double vals[3] = {0., 0., 0.};
+            std::vector<size_t> poly;
+
+            for (size_t iP = 0; iP < element.properties.size(); iP++) {
+              const PlyProperty& property = element.properties[iP];
+              double val;
+              long long count = 1;
+              if (property.isList && !parseInteger(p, end, count)) count = -1;
+              for (long long iE = 0; iE < count; iE++) {
+                if (!parseDouble(p, end, val)) count = -1;
+                if (count < 0) break;
+                if (iLine < nVertices) {
+                  if ((long)iP == iX) vals[0] = val;
+                  if ((long)iP == iY) vals[1] = val;
+                  if ((long)iP == iZ) vals[2] = val;
+                } else if ((long)iP == iIndices) {
+                  poly.push_back(checkIndex(val));
+                }
+              }
+              if (count < 0) throw std::runtime_error("malformed line in ply file: " + std::string(line, end));
+            }
+
+            if (iLine < nVertices) {
+              soup.positions[iLine] = Vector3{vals[0], vals[1], vals[2]};
+            } else {
+              soup.polygons[iLine - nVertices] = std::move(poly);
+            }
+            line = end + 1;
+          }
+        },
+        nThreads, 1);
+
+    return soup;
+  }
+
+  bool swap = (header.format == PlyFormat::BinaryLittleEndian) != hostIsLittleEndian();
+
+  // Vertices have a fixed size, so they can be decoded directly in parallel
+  size_t vertexSize = 0;
+  std::vector<size_t> propertyOffset;
+  for (const PlyProperty& property : vertexElement.properties) {
+    propertyOffset.push_back(vertexSize);
+    vertexSize += property.valueType.size;
+  }
+  if ((size_t)(fileEnd - body) < nVertices * vertexSize) throw std::runtime_error("ply file is truncated");
+  parallelFor(
+      nVertices,
+      [&](size_t iV) {
+        const char* vertex = body + iV * vertexSize;
+        Vector3& pos = soup.positions[iV];
+        pos.x = readBinaryValue(vertex + propertyOffset[iX], vertexElement.properties[iX].valueType, swap);
+        pos.y = readBinaryValue(vertex + propertyOffset[iY], vertexElement.properties[iY].valueType, swap);
+        pos.z = readBinaryValue(vertex + propertyOffset[iZ], vertexElement.properties[iZ].valueType, swap);
+      },
+      nThreads);
+
+  // Faces vary in size, so first find where each one starts with a quick serial scan over the list counts
+  const char* faces = body + nVertices * vertexSize;
+  std::vector<size_t> faceOffset(nFaces + 1);
+  size_t offset = 0;
+  for (size_t iF = 0; iF < nFaces; iF++) {
+    faceOffset[iF] = offset;
+    for (const PlyProperty& property : faceElement.properties) {
+      if (faces + offset + property.countType.size * property.isList > fileEnd) {
+        throw std::runtime_error("ply file is truncated");
+      }
+      size_t count = 1;
+      if (property.isList) {
+        count = readBinaryValue(faces + offset, property.countType, swap);
+        offset += property.countType.size;
+      }
+      offset += count * property.valueType.size;
+    }
+  }
+  faceOffset[nFaces] = offset;
+  if (faces + offset > fileEnd) throw std::runtime_error("ply file is truncated");
+
+  parallelFor(
+      nFaces,
+      [&](size_t iF) {
+        const char* p = faces + faceOffset[iF];
+        for (size_t iP = 0; iP < faceElement.properties.size(); iP++) {
+          const PlyProperty& property = faceElement.properties[iP];
+          size_t count = 1;
+          if (property.isList) {
+            count = readBinaryValue(p, property.countType, swap);
+            p += property.countType.size;
+          }
+          if ((long)iP == iIndices) {
+            std::vector<size_t>& poly = soup.polygons[iF];
+            poly.resize(count);
+            for (size_t iE = 0; iE < count; iE++) {
+              poly[iE] = checkIndex(readBinaryValue(p + iE * property.valueType.size, property.valueType, swap));
+            }
+          }
+          p += count * property.valueType.size;
+        }
+      },
+      nThreads);
+
+  return soup;
+}
+
+std::string lowercaseExtension(std::string filename) {
+  size_t dot = filename.find_last_of('.');
+  if (dot == std::string::npos) return "";
+  std::string ext = filename.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+  return ext;
+}
+
+PolygonSoup readPolygonSoup(std::string filename, size_t nThreads) {
+  std::string ext = lowercaseExtension(filename);
+  if (ext == "obj" || ext == "ply") {
+    try {
+      MappedFile file(filename);
+      return ext == "obj" ? parseObj(file, nThreads) : parsePly(file, nThreads);
+    } catch (const UnsupportedFile&) {
+      // fall through to geometry-central's reader
+    }
+  }
+
+  SimplePolygonMesh simpleMesh(filename);
+  PolygonSoup soup;
+  soup.positions = std::move(simpleMesh.vertexCoordinates);
+  soup.polygons = std::move(simpleMesh.polygons);
+  return soup;
+}
+
+// == Connectivity
+
+// Find the twin of every polygon side by sorting the sides by their unordered pair of endpoints, so that twins are
+// adjacent. Side iC of a polygon runs from its corner iC to corner iC + 1.
+TwinList matchTwins(const std::vector<std::vector<size_t>>& polygons, size_t nThreads) {
+  struct Side {
+    size_t vMin, vMax;
+    size_t face, corner;
+  };
+
+  std::vector<size_t> sideStart(polygons.size() + 1, 0);
+  for (size_t iF = 0; iF < polygons.size(); iF++) sideStart[iF + 1] = sideStart[iF] + polygons[iF].size();
+
+  std::vector<Side> sides(sideStart.back());
+  TwinList twins(polygons.size());
+  parallelFor(
+      polygons.size(),
+      [&](size_t iF) {
+        const std::vector<size_t>& poly = polygons[iF];
+        twins[iF].assign(poly.size(), std::make_tuple(INVALID_IND, INVALID_IND));
+        for (size_t iC = 0; iC < poly.size(); iC++) {
+          size_t vA = poly[iC];
+          size_t vB = poly[(iC + 1) % poly.size()];
+          if (vA == vB) throw std::runtime_error("mesh has a degenerate edge at vertex " + std::to_string(vA));
+          sides[sideStart[iF] + iC] = Side{std::min(vA, vB), std::max(vA, vB), iF, iC};
+        }
+      },
+      nThreads);
+
+  parallelSort(
+      sides.begin(), sides.end(),
+      [](const Side& a, const Side& b) {
+        // Break ties between the sides of an edge by face, so that the order does not depend on the thread count
+        if (a.vMin != b.vMin) return a.vMin < b.vMin;
+        if (a.vMax != b.vMax) return a.vMax < b.vMax;
+        return a.face != b.face ? a.face < b.face : a.corner < b.corner;
+      },
+      nThreads);
+
+  auto sameEdge = [&](size_t iA, size_t iB) {
+    return sides[iA].vMin == sides[iB].vMin && sides[iA].vMax == sides[iB].vMax;
+  };
+  auto tail = [&](const Side& s) { return polygons[s.face][s.corner]; };
+  // Only built for error messages, since the loop below runs once per edge
+  auto sideEdgeName = [](const Side& s) {
+    return "(" + std::to_string(s.vMin) + ", " + std::to_string(s.vMax) + ")";
+  };
+
+  // Interior edges have exactly two sides, running in opposite directions
+  parallelFor(
+      sides.size(),
+      [&](size_t iS) {
+        if (iS > 0 && sameEdge(iS - 1, iS)) return;
+        if (iS + 1 == sides.size() || !sameEdge(iS, iS + 1)) return; // boundary
+        if (iS + 2 < sides.size() && sameEdge(iS, iS + 2)) {
+          throw std::runtime_error("mesh has a nonmanifold edge " + sideEdgeName(sides[iS]));
+        }
+        const Side& a = sides[iS];
+        const Side& b = sides[iS + 1];
+        if (tail(a) == tail(b)) {
+          throw std::runtime_error("mesh is not consistently oriented at edge " + sideEdgeName(a));
+        }
+        twins[a.face][a.corner] = std::make_tuple(b.face, b.corner);
+        twins[b.face][b.corner] = std::make_tuple(a.face, a.corner);
+      },
+      nThreads);
+
+  return twins;
+}
+
+// == Binary cache
+//
+// A cache file holds the polygons, positions and twins exactly as passed to the mesh constructor, as raw arrays in the
+// host's byte order (files from a host with a different byte order are ignored):
+//
+//   char[8]   magic "ITMESH\0\0"
+//   uint32    format version (currently 1), uint32 byte order marker 0x01020304
+//   uint64    source file size, int64 source file modification time, uint64 1 if triangulated else 0
+//   uint64    nVertices, nPolygons, nCorners
+//   double    positions[3 * nVertices]
+//   uint64    polygonStart[nPolygons + 1]
+//   uint64    corners[nCorners]
+//   uint64    twins[nCorners] (the flat corner index of each side's twin, or UINT64_MAX on the boundary)
+
+const char MESH_CACHE_MAGIC[8] = {'I', 'T', 'M', 'E', 'S', 'H', 0, 0};
+const uint32_t MESH_CACHE_VERSION = 1;
+const uint32_t MESH_CACHE_BYTE_ORDER = 0x01020304;
+const size_t MESH_CACHE_HEADER_SIZE = 64;
+
+struct SourceStamp {
+  uint64_t size;
+  int64_t mtime;
+};
+
+SourceStamp stampFile(std::string filename) {
+  struct stat info;
+  if (stat(filename.c_str(), &info) != 0) throw std::runtime_error("failed to stat " + filename);
+  return SourceStamp{(uint64_t)info.st_size, (int64_t)info.st_mtime};
+}
+
+std::string meshCachePath(std::string cacheDir, std::string filename, bool triangulate) {
+  // FNV-1a hash of the path as given, so that same-named meshes in different directories get different entries
+  std::string hashHex = hashToHex(fnv1aHash(filename));
+
+  std::string base = filename.substr(filename.find_last_of("/\\") + 1);
+  if (!cacheDir.empty() && cacheDir.back() != '/' && cacheDir.back() != '\\') cacheDir += "/";
+  return cacheDir + base + "." + hashHex + (triangulate ? ".tri" : "") + ".itmesh";
+}
+
+template <typename T>
+void appendRaw(std::string& out, const T* data, size_t n) {
+  out.append(reinterpret_cast<const char*>(data), n * sizeof(T));
+}
+
+void writeMeshCache(std::string cachePath, SourceStamp stamp, bool triangulate, const PolygonSoup& soup,
+                    const TwinList& twins) {
+  std::vector<uint64_t> polygonStart(soup.polygons.size() + 1, 0);
+  for (size_t iF = 0; iF < soup.polygons.size(); iF++) {
+    polygonStart[iF + 1] = polygonStart[iF] + soup.polygons[iF].size();
+  }
+  size_t nCorners = polygonStart.back();
+
+  std::vector<uint64_t> corners(nCorners), twinCorners(nCorners);
+  for (size_t iF = 0; iF < soup.polygons.size(); iF++) {
+    for (size_t iC = 0; iC < soup.polygons[iF].size(); iC++) {
+      corners[polygonStart[iF] + iC] = soup.polygons[iF][iC];
+      size_t twinFace = std::get<0>(twins[iF][iC]);
+      twinCorners[polygonStart[iF] + iC] =
+          twinFace == INVALID_IND ? UINT64_MAX : polygonStart[twinFace] + std::get<1>(twins[iF][iC]);
+    }
+  }
+
+  std::string out;
+  out.append(MESH_CACHE_MAGIC, 8);
+  appendRaw(out, &MESH_CACHE_VERSION, 1);
+  appendRaw(out, &MESH_CACHE_BYTE_ORDER, 1);
+  uint64_t counts[6] = {stamp.size, (uint64_t)stamp.mtime, triangulate ? 1u : 0u, soup.positions.size(),
+                        soup.polygons.size(), nCorners};
+  appendRaw(out, counts, 6);
+  for (const Vector3& p : soup.positions) {
+    double xyz[3] = {p.x, p.y, p.z};
+    appendRaw(out, xyz, 3);
+  }
+  appendRaw(out, polygonStart.data(), polygonStart.size());
+  appendRaw(out, corners.data(), nCorners);
+  appendRaw(out, twinCorners.data(), nCorners);
+
+  // Write to a temporary file and rename it into place, so that concurrent runs never see a partial cache file. The
+  // name is unique to this process and thread, so that no two writers share a temporary file.
+#ifdef _WIN32
+  long pid = _getpid();
+#else
+  long pid = getpid();
+#endif
+  std::string tmpPath = cachePath + ".tmp" + std::to_string(pid) + "." +
+                        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  AsyncFileWriter::writeFile(tmpPath, out);
+  std::remove(cachePath.c_str());
+  if (std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    throw std::runtime_error("failed to write mesh cache " + cachePath);
+  }
+}
+
+// Returns false if there is no valid cache entry for the source file
+bool readMeshCache(std::string cachePath, SourceStamp stamp, bool triangulate, PolygonSoup& soup, TwinList& twins,
+                   size_t nThreads) {
+  struct stat info;
+  if (stat(cachePath.c_str(), &info) != 0) return false;
+
+  MappedFile file(cachePath);
+  const char* data = file.data();
+  if (file.size() < MESH_CACHE_HEADER_SIZE || std::memcmp(data, MESH_CACHE_MAGIC, 8) != 0) return false;
+
+  uint32_t versionAndOrder[2];
+  uint64_t counts[6];
+  std::memcpy(versionAndOrder, data + 8, sizeof(versionAndOrder));
+  std::memcpy(counts, data + 16, sizeof(counts));
+  if (versionAndOrder[0] != MESH_CACHE_VERSION || versionAndOrder[1] != MESH_CACHE_BYTE_ORDER) return false;
+  if (counts[0] != stamp.size || (int64_t)counts[1] != stamp.mtime || counts[2] != (triangulate ? 1u : 0u)) {
+    return false;
+  }
+
+  size_t nVertices = counts[3], nPolygons = counts[4], nCorners = counts[5];
+  size_t expectedSize =
+      MESH_CACHE_HEADER_SIZE + 3 * nVertices * sizeof(double) + (nPolygons + 1 + 2 * nCorners) * sizeof(uint64_t);
+  if (file.size() != expectedSize) return false;
+
+  const char* positions = data + MESH_CACHE_HEADER_SIZE;
+  const char* polygonStart = positions + 3 * nVertices * sizeof(double);
+  const char* corners = polygonStart + (nPolygons + 1) * sizeof(uint64_t);
+  const char* twinCorners = corners + nCorners * sizeof(uint64_t);
+  auto readU64 = [](const char* array, size_t i) {
+    uint64_t val;
+    std::memcpy(&val, array + i * sizeof(uint64_t), sizeof(uint64_t));
+    return val;
+  };
+
+  // Flat corner index -> (polygon, corner), found by binary search over the polygon starts
+  auto cornerInPolygon = [&](uint64_t iFlat) {
+    size_t lo = 0, hi = nPolygons;
+    while (hi - lo > 1) {
+      size_t mid = (lo + hi) / 2;
+      if (readU64(polygonStart, mid) <= iFlat) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    return std::make_tuple(lo, (size_t)(iFlat - readU64(polygonStart, lo)));
+  };
+
+  soup.positions.resize(nVertices);
+  soup.polygons.resize(nPolygons);
+  twins.resize(nPolygons);
+  parallelFor(
+      nVertices,
+      [&](size_t iV) {
+        double xyz[3];
+        std::memcpy(xyz, positions + 3 * iV * sizeof(double), sizeof(xyz));
+        soup.positions[iV] = Vector3{xyz[0], xyz[1], xyz[2]};
+      },
+      nThreads);
+  parallelFor(
+      nPolygons,
+      [&](size_t iF) {
+        size_t start = readU64(polygonStart, iF);
+        size_t degree = readU64(polygonStart, iF + 1) - start;
+        soup.polygons[iF].resize(degree);
+        twins[iF].resize(degree);
+        for (size_t iC = 0; iC < degree; iC++) {
+          soup.polygons[iF][iC] = readU64(corners, start + iC);
+          uint64_t twin = readU64(twinCorners, start + iC);
+          twins[iF][iC] = twin == UINT64_MAX ? std::make_tuple(INVALID_IND, INVALID_IND) : cornerInPolygon(twin);
+        }
+      },
+      nThreads);
+
+  return true;
+}
+
+} // namespace
+
+std::vector<std::vector<size_t>> fanTriangulate(const std::vector<std::vector<size_t>>& polygons, size_t nThreads) {
+  // Offset of each polygon's first triangle
+  std::vector<size_t> triStart(polygons.size() + 1, 0);
+  for (size_t iP = 0; iP < polygons.size(); iP++) {
+    size_t degree = polygons[iP].size();
+    triStart[iP + 1] = triStart[iP] + (degree >= 3 ? degree - 2 : 0);
+  }
+
+  std::vector<std::vector<size_t>> triangles(triStart.back());
+  parallelFor(
+      polygons.size(),
+      [&](size_t iP) {
+        const std::vector<size_t>& poly = polygons[iP];
+        for (size_t iT = 0; iT + 2 < poly.size(); iT++) {
+          triangles[triStart[iP] + iT] = {poly[0], poly[iT + 1], poly[iT + 2]};
+        }
+      },
+      nThreads);
+
+  return triangles;
+}
+
+std::tuple<std::unique_ptr<ManifoldSurfaceMesh>, std::unique_ptr<VertexPositionGeometry>>
+loadManifoldMesh(std::string filename, bool triangulate, std::string cacheDir, size_t nThreads) {
+  PolygonSoup soup;
+  TwinList twins;
+
+  std::string cachePath;
+  SourceStamp stamp{0, 0};
+  if (!cacheDir.empty()) {
+    stamp = stampFile(filename);
+    cachePath = meshCachePath(cacheDir, filename, triangulate);
+    if (readMeshCache(cachePath, stamp, triangulate, soup, twins, nThreads)) {
+      return makeManifoldSurfaceMeshAndGeometry(soup.polygons, twins, soup.positions);
+    }
+  }
+
+  soup = readPolygonSoup(filename, nThreads);
+  if (triangulate) {
+    soup.polygons = fanTriangulate(soup.polygons, nThreads);
+  }
+  twins = matchTwins(soup.polygons, nThreads);
+
+  if (!cachePath.empty()) {
+    try {
+      writeMeshCache(cachePath, stamp, triangulate, soup, twins);
+    } catch (const std::exception& e) {
+      // A missing cache only costs time on the next run
+      std::cerr << "Warning: " << e.what() << std::endl;
+    }
+  }
+
+  return makeManifoldSurfaceMeshAndGeometry(soup.polygons, twins, soup.positions);
+}
+
+std::tuple<std::unique_ptr<ManifoldSurfaceMesh>, std::unique_ptr<VertexPositionGeometry>>
+makeManifoldMesh(const std::vector<std::vector<size_t>>& polygons, const std::vector<Vector3>& vertexPositions,
+                 size_t nThreads) {
+  return makeManifoldSurfaceMeshAndGeometry(polygons, matchTwins(polygons, nThreads), vertexPositions);
+}
+
+std::string meshNameFromPath(std::string path) {
+  size_t start = path.find_last_of("/\\");
+  start = start == std::string::npos ? 0 : start + 1;
+  size_t end = path.rfind('.');
+  if (end == std::string::npos) end = path.size();
+  if (start >= end) return path;
+  return path.substr(start, end - start);
+}
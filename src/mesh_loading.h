@@ -0,0 +1,38 @@
+#pragma once
+
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Split every polygon into a fan of triangles around its first vertex, leaving triangles as they are. The output is
+// allocated once up front and filled in parallel over nThreads threads (0 for one per hardware thread).
+std::vector<std::vector<size_t>> fanTriangulate(const std::vector<std::vector<size_t>>& polygons, size_t nThreads = 0);
+
+// Load a manifold mesh from a file, like readManifoldSurfaceMesh(). If triangulate is set, polygons are triangulated
+// before the mesh is built, rather than by modifying the mesh after loading.
+//
+// OBJ and PLY files (ASCII or binary, with vertices followed by faces) are memory-mapped and parsed in parallel chunks,
+// and the twin of each polygon side is found with a parallel sort of all sides by their endpoints. Anything else is
+// read by geometry-central's SimplePolygonMesh.
+//
+// If cacheDir is not empty, the parsed polygons and their twins are saved there in a binary file keyed by the mesh's
+// path, and later loads of the same, unmodified file read that instead.
+std::tuple<std::unique_ptr<geometrycentral::surface::ManifoldSurfaceMesh>,
+           std::unique_ptr<geometrycentral::surface::VertexPositionGeometry>>
+loadManifoldMesh(std::string filename, bool triangulate, std::string cacheDir = "", size_t nThreads = 0);
+
+// Build a manifold mesh from polygons over the given vertex positions, matching the twin of each polygon side as
+// loadManifoldMesh() does. Throws if the polygons do not form a manifold mesh.
+std::tuple<std::unique_ptr<geometrycentral::surface::ManifoldSurfaceMesh>,
+           std::unique_ptr<geometrycentral::surface::VertexPositionGeometry>>
+makeManifoldMesh(const std::vector<std::vector<size_t>>& polygons,
+                 const std::vector<geometrycentral::Vector3>& vertexPositions, size_t nThreads = 0);
+
+// The name of a mesh file without its directory or extension, e.g. "bunny" for "meshes/bunny.obj", or the whole path
+// if its last '.' comes before its last separator. This matches polyscope::guessNiceNameFromPath(), which names the
+// mesh in the GUI, so that output prefixes are the same with or without polyscope.
+std::string meshNameFromPath(std::string path);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+// The number of threads to use when nThreads are requested, where 0 means one per hardware thread
+inline size_t resolveThreadCount(size_t nThreads) {
+  return nThreads > 0 ? nThreads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Call body(i) for every i in [0, n), splitting the range into one contiguous block per thread. Uses up to nThreads
+// threads, or one per hardware thread if nThreads is 0, but never gives a thread fewer than minBlockSize indices, so
+// small ranges run inline. body must be safe to call concurrently for different i. If any call throws, the exception
+// from the smallest failing i is rethrown once every thread has finished, so the error does not depend on the number
+// of threads.
+template <typename Body>
+void parallelFor(size_t n, Body body, size_t nThreads = 0, size_t minBlockSize = 4096) {
+  nThreads = std::min(resolveThreadCount(nThreads), (n + minBlockSize - 1) / minBlockSize);
+  if (nThreads <= 1) {
+    for (size_t i = 0; i < n; i++) body(i);
+    return;
+  }
+
+  // Each block stops at its first failure, so the lowest failing block holds the smallest failing index
+  size_t blockSize = (n + nThreads - 1) / nThreads;
+  size_t nBlocks = (n + blockSize - 1) / blockSize;
+  std::vector<std::exception_ptr> errors(nBlocks);
+  auto runBlock = [&](size_t iB) {
+    try {
+      for (size_t i = iB * blockSize; i < std::min((iB + 1) * blockSize, n); i++) body(i);
+    } catch (...) {
+      errors[iB] = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t iB = 1; iB < nBlocks; iB++) threads.emplace_back(runBlock, iB);
+  runBlock(0);
+  for (std::thread& t : threads) t.join();
+
+  for (const std::exception_ptr& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+}
+
+// Sort [first, last) by splitting it into one block per thread, sorting the blocks concurrently, then merging pairs of
+// neighbouring blocks concurrently until one remains. Not stable. Uses up to nThreads threads, or one per hardware
+// thread if nThreads is 0.
+template <typename It, typename Compare>
+void parallelSort(It first, It last, Compare comp, size_t nThreads = 0) {
+  const size_t minBlockSize = 1 << 16;
+
+  size_t n = last - first;
+  size_t nBlocks = std::min(resolveThreadCount(nThreads), (n + minBlockSize - 1) / minBlockSize);
+  if (nBlocks <= 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  std::vector<size_t> blockStart(nBlocks + 1);
+  for (size_t iB = 0; iB <= nBlocks; iB++) blockStart[iB] = n * iB / nBlocks;
+
+  parallelFor(
+      nBlocks, [&](size_t iB) { std::sort(first + blockStart[iB], first + blockStart[iB + 1], comp); }, nBlocks, 1);
+
+  // Each round merges blocks 2k and 2k+1, halving the number of blocks
+  while (blockStart.size() > 2) {
+    size_t nMerges = (blockStart.size() - 1) / 2;
+    parallelFor(
+        nMerges,
+        [&](size_t iM) {
+          std::inplace_merge(first + blockStart[2 * iM], first + blockStart[2 * iM + 1], first + blockStart[2 * iM + 2],
+                             comp);
+        },
+        nMerges, 1);
+
+    std::vector<size_t> merged;
+    for (size_t iB = 0; iB < blockStart.size(); iB += 2) merged.push_back(blockStart[iB]);
+    if (merged.back() != n) merged.push_back(n);
+    blockStart = merged;
+  }
+}
@@ -0,0 +1,337 @@
+#include "parallel_delaunay.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+namespace {
+
+// Matches the tolerance geometry-central uses when testing edges in flipToDelaunay()
+const double DELAUNAY_EPS = 1e-6;
+
+// Area of a triangle with side lengths a, b, c, by Heron's formula
+double triangleArea(double a, double b, double c) {
+  return 0.25 * std::sqrt(std::max(0., (a + b + c) * (-a + b + c) * (a - b + c) * (a + b - c)));
+}
+
+// Cotangent of the angle opposite he in its face, from the intrinsic edge lengths alone
+double oppositeCotan(IntrinsicTriangulation& intTri, Halfedge he) {
+  double a = intTri.intrinsicEdgeLengths[he.edge()];
+  double b = intTri.intrinsicEdgeLengths[he.next().edge()];
+  double c = intTri.intrinsicEdgeLengths[he.next().next().edge()];
+  return (b * b + c * c - a * a) / (4 * triangleArea(a, b, c));
+}
+
+// Whether e satisfies the Delaunay condition. Only reads the triangulation, so it is safe to call concurrently as long
+// as nothing is flipping. Degenerate triangles count as non-Delaunay, leaving the decision to flipEdgeIfNotDelaunay().
+bool isLocallyDelaunay(IntrinsicTriangulation& intTri, Edge e) {
+  if (e.isBoundary()) return true;
+  double weight = 0.5 * (oppositeCotan(intTri, e.halfedge()) + oppositeCotan(intTri, e.halfedge().twin()));
+  return weight >= -DELAUNAY_EPS;
+}
+
+// Flip every non-Delaunay edge among the candidates in rounds, adding the edges around each flip as candidates for the
+// next round, until no candidates are left or control stops the rounds. Edges which flipEdgeIfNotDelaunay() refuses to
+// flip (such as fixed edges) are dropped from the rounds, and appended to leftovers unless a later flip next to them
+// makes them candidates again. Candidates which have since been deleted are skipped, as edges gathered around one
+// insertion may be by a later one.
+void flipCandidatesInRounds(IntrinsicTriangulation& intTri, std::vector<size_t> candidates, size_t nThreads,
+                            FlipRoundStats& stats, const RoundControl& control, std::vector<size_t>& leftovers) {
+  ManifoldSurfaceMesh& mesh = intTri.mesh;
+  candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                  [&](size_t iE) { return iE >= mesh.nEdgesCapacity() || mesh.edge(iE).isDead(); }),
+                   candidates.end());
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+  std::vector<char> isBad;
+  std::vector<char> faceClaimed(mesh.nFacesCapacity(), false);
+  std::vector<size_t> selected, nextCandidates, refused;
+  while (!candidates.empty()) {
+    isBad.assign(candidates.size(), false);
+    parallelFor(
+        candidates.size(), [&](size_t iC) { isBad[iC] = !isLocallyDelaunay(intTri, mesh.edge(candidates[iC])); },
+        nThreads);
+
+    // Greedily take each bad edge whose triangles no earlier edge has claimed, deferring the others a round. The first
+    // bad edge is always taken, so every round either flips an edge or drops a refused one.
+    selected.clear();
+    nextCandidates.clear();
+    for (size_t iC = 0; iC < candidates.size(); iC++) {
+      if (!isBad[iC]) continue;
+      Edge e = mesh.edge(candidates[iC]);
+      size_t fA = e.halfedge().face().getIndex();
+      size_t fB = e.halfedge().twin().face().getIndex();
+      if (faceClaimed[fA] || faceClaimed[fB]) {
+        nextCandidates.push_back(candidates[iC]);
+        continue;
+      }
+      faceClaimed[fA] = faceClaimed[fB] = true;
+      selected.push_back(candidates[iC]);
+    }
+
+    size_t nFlipped = 0;
+    for (size_t iE : selected) {
+      Edge e = mesh.edge(iE);
+      Halfedge he = e.halfedge();
+      faceClaimed[he.face().getIndex()] = faceClaimed[he.twin().face().getIndex()] = false;
+      if (!intTri.flipEdgeIfNotDelaunay(e)) {
+        refused.push_back(iE);
+        continue;
+      }
+      nFlipped++;
+
+      he = e.halfedge();
+      nextCandidates.push_back(he.next().edge().getIndex());
+      nextCandidates.push_back(he.next().next().edge().getIndex());
+      nextCandidates.push_back(he.twin().next().edge().getIndex());
+      nextCandidates.push_back(he.twin().next().next().edge().getIndex());
+    }
+
+    stats.nRounds++;
+    stats.nFlips += nFlipped;
+    if (control.progress) control.progress(stats.nRounds, stats.nFlips);
+
+    std::sort(nextCandidates.begin(), nextCandidates.end());
+    nextCandidates.erase(std::unique(nextCandidates.begin(), nextCandidates.end()), nextCandidates.end());
+    std::swap(candidates, nextCandidates);
+
+    if (control.shouldStop()) {
+      stats.stoppedEarly = true;
+      break;
+    }
+  }
+
+  // Refused edges which became candidates again were tested again, so only the others are left over
+  std::sort(refused.begin(), refused.end());
+  refused.erase(std::unique(refused.begin(), refused.end()), refused.end());
+  for (size_t iE : refused) {
+    if (!std::binary_search(candidates.begin(), candidates.end(), iE)) leftovers.push_back(iE);
+  }
+  if (stats.stoppedEarly) leftovers.insert(leftovers.end(), candidates.begin(), candidates.end());
+}
+
+// Flip the given edges to Delaunay serially with a queue, as IntrinsicTriangulation::flipToDelaunay() does, but
+// starting from these edges rather than every edge of the mesh. Edges which have since been deleted are skipped.
+void flipLeftoversToDelaunay(IntrinsicTriangulation& intTri, std::vector<size_t> leftovers) {
+  ManifoldSurfaceMesh& mesh = intTri.mesh;
+  std::vector<char> inQueue(mesh.nEdgesCapacity(), false);
+  std::vector<size_t> queue;
+  for (size_t iE : leftovers) {
+    if (iE >= inQueue.size() || inQueue[iE] || mesh.edge(iE).isDead()) continue;
+    inQueue[iE] = true;
+    queue.push_back(iE);
+  }
+
+  // Process the queue in order, so that the result does not depend on anything but the leftovers
+  for (size_t iQ = 0; iQ < queue.size(); iQ++) {
+    Edge e = mesh.edge(queue[iQ]);
+    inQueue[queue[iQ]] = false;
+    if (!intTri.flipEdgeIfNotDelaunay(e)) continue;
+
+    Halfedge he = e.halfedge();
+    for (Halfedge neighbor : {he.next(), he.next().next(), he.twin().next(), he.twin().next().next()}) {
+      size_t iN = neighbor.edge().getIndex();
+      if (inQueue[iN]) continue;
+      inQueue[iN] = true;
+      queue.push_back(iN);
+    }
+  }
+}
+
+// Interior angle opposite side a of a triangle with side lengths a, b, c
+double oppositeAngle(double a, double b, double c) {
+  double cosAngle = (b * b + c * c - a * a) / (2 * b * c);
+  return std::acos(std::max(-1., std::min(1., cosAngle)));
+}
+
+// Angle at the tail of an interior halfedge, in its face
+double cornerAngle(IntrinsicTriangulation& intTri, Halfedge he) {
+  return oppositeAngle(intTri.intrinsicEdgeLengths[he.next().edge()], intTri.intrinsicEdgeLengths[he.edge()],
+                       intTri.intrinsicEdgeLengths[he.next().next().edge()]);
+}
+
+// A face's halfedges, their tail vertices and their edge lengths, as LaplacianAssembler stamps faces. Face indices
+// are reused as the mesh changes, so a handle taken before an edit refers to the same triangle afterwards only if its
+// stamp is unchanged.
+struct FaceStamp {
+  std::array<size_t, 3> halfedges;
+  std::array<size_t, 3> vertices;
+  std::array<double, 3> lengths;
+  bool operator==(const FaceStamp& other) const {
+    return halfedges == other.halfedges && vertices == other.vertices && lengths == other.lengths;
+  }
+};
+
+FaceStamp stampOf(IntrinsicTriangulation& intTri, Face f) {
+  FaceStamp stamp;
+  Halfedge he = f.halfedge();
+  for (int c = 0; c < 3; c++) {
+    stamp.halfedges[c] = he.getIndex();
+    stamp.vertices[c] = he.vertex().getIndex();
+    stamp.lengths[c] = intTri.intrinsicEdgeLengths[he.edge()];
+    he = he.next();
+  }
+  return stamp;
+}
+
+// Sum of the interior angles around v
+double angleSum(IntrinsicTriangulation& intTri, Vertex v) {
+  double sum = 0;
+  for (Halfedge he : v.outgoingHalfedges()) {
+    if (he.isInterior()) sum += cornerAngle(intTri, he);
+  }
+  return sum;
+}
+
+} // namespace
+
+FlipRoundStats flipToDelaunayInRounds(IntrinsicTriangulation& intTri, size_t nThreads, const RoundControl& control) {
+  FlipRoundStats stats;
+  std::vector<size_t> candidates, leftovers;
+  candidates.reserve(intTri.mesh.nEdges());
+  for (Edge e : intTri.mesh.edges()) candidates.push_back(e.getIndex());
+  flipCandidatesInRounds(intTri, candidates, nThreads, stats, control, leftovers);
+
+  // Whatever the rounds could not flip, such as fixed edges, is left to a serial queue
+  if (!stats.stoppedEarly) flipLeftoversToDelaunay(intTri, leftovers);
+  return stats;
+}
+
+RefineRoundStats delaunayRefineInRounds(IntrinsicTriangulation& intTri, double angleThreshDegrees,
+                                        double circumradiusThresh, size_t maxInsertions, size_t nThreads,
+                                        const RoundControl& control) {
+  ManifoldSurfaceMesh& mesh = intTri.mesh;
+  RefineRoundStats stats;
+  FlipRoundStats flipStats;
+  const double angleThresh = angleThreshDegrees * PI / 180.;
+  const double minAngleSum = 60. * PI / 180.;
+
+  auto needsRefinement = [&](Face f) {
+    Halfedge he = f.halfedge();
+    double a = intTri.intrinsicEdgeLengths[he.edge()];
+    double b = intTri.intrinsicEdgeLengths[he.next().edge()];
+    double c = intTri.intrinsicEdgeLengths[he.next().next().edge()];
+    double minAngle = std::min(oppositeAngle(a, b, c), std::min(oppositeAngle(b, c, a), oppositeAngle(c, a, b)));
+    return minAngle < angleThresh || a * b * c / (4 * triangleArea(a, b, c)) > circumradiusThresh;
+  };
+
+  // The initial flips share the limits, but report no progress of their own since they insert nothing
+  RoundControl flipControl;
+  flipControl.deadline = control.deadline;
+  flipControl.cancel = control.cancel;
+  if (flipToDelaunayInRounds(intTri, nThreads, flipControl).stoppedEarly) {
+    stats.stoppedEarly = true;
+    return stats;
+  }
+
+  std::vector<Vertex> vertices;
+  std::vector<Face> faces, bad, selected;
+  std::vector<FaceStamp> selectedStamps;
+  std::vector<double> angleSums, faceArea;
+  std::vector<char> isBad, faceClaimed;
+  std::vector<size_t> flipCandidates, flipLeftovers;
+  while (stats.nInsertions < maxInsertions) {
+    vertices.clear();
+    faces.clear();
+    for (Vertex v : mesh.vertices()) vertices.push_back(v);
+    for (Face f : mesh.faces()) faces.push_back(f);
+
+    // Test every face concurrently. Faces touching a vertex with a small angle sum are never refined, as in
+    // minAngleDegreesAtValidFaces(): inserting near such a cone would only create more small angles.
+    angleSums.assign(mesh.nVerticesCapacity(), 0.);
+    parallelFor(
+        vertices.size(), [&](size_t iV) { angleSums[vertices[iV].getIndex()] = angleSum(intTri, vertices[iV]); },
+        nThreads);
+
+    isBad.assign(faces.size(), false);
+    faceArea.assign(mesh.nFacesCapacity(), 0.);
+    parallelFor(
+        faces.size(),
+        [&](size_t iF) {
+          Face f = faces[iF];
+          Halfedge he = f.halfedge();
+          faceArea[f.getIndex()] =
+              triangleArea(intTri.intrinsicEdgeLengths[he.edge()], intTri.intrinsicEdgeLengths[he.next().edge()],
+                           intTri.intrinsicEdgeLengths[he.next().next().edge()]);
+          for (Vertex v : f.adjacentVertices()) {
+            if (angleSums[v.getIndex()] < minAngleSum) return;
+          }
+          isBad[iF] = needsRefinement(f);
+        },
+        nThreads);
+
+    // Largest faces first, as geometry-central's queue does, with ties broken by index
+    bad.clear();
+    for (size_t iF = 0; iF < faces.size(); iF++) {
+      if (isBad[iF]) bad.push_back(faces[iF]);
+    }
+    if (bad.empty()) break;
+    parallelSort(
+        bad.begin(), bad.end(),
+        [&](Face fA, Face fB) {
+          double areaA = faceArea[fA.getIndex()];
+          double areaB = faceArea[fB.getIndex()];
+          return areaA != areaB ? areaA > areaB : fA.getIndex() < fB.getIndex();
+        },
+        nThreads);
+
+    // Pick faces whose neighbourhoods (every face around each of their vertices) do not overlap, as a stand-in for
+    // the insertion cavities, which are not known until each circumcenter has been located
+    selected.clear();
+    selectedStamps.clear();
+    faceClaimed.assign(mesh.nFacesCapacity(), false);
+    for (Face f : bad) {
+      if (stats.nInsertions + selected.size() >= maxInsertions) break;
+      bool isFree = true;
+      for (Vertex v : f.adjacentVertices()) {
+        for (Face g : v.adjacentFaces()) isFree = isFree && !faceClaimed[g.getIndex()];
+      }
+      if (!isFree) continue;
+      for (Vertex v : f.adjacentVertices()) {
+        for (Face g : v.adjacentFaces()) faceClaimed[g.getIndex()] = true;
+      }
+      selected.push_back(f);
+      selectedStamps.push_back(stampOf(intTri, f));
+    }
+
+    // Insert serially, since every insertion updates the backend's shared state, then restore Delaunay around the
+    // new vertices. A circumcenter can land outside its face's neighbourhood, where inserting it, splitting a boundary
+    // segment, or removing vertices inserted near that segment changes faces picked later in the round; their indices
+    // may even be reused by new triangles. So each face is only refined if it is still alive and its stamp unchanged,
+    // and if its vertices are still clear of small cones. The others are tested again next round.
+    flipCandidates.clear();
+    size_t nInserted = 0;
+    for (size_t iS = 0; iS < selected.size(); iS++) {
+      Face f = selected[iS];
+      if (f.isDead() || !(stampOf(intTri, f) == selectedStamps[iS])) continue;
+      bool nearCone = false;
+      for (Vertex v : f.adjacentVertices()) nearCone = nearCone || angleSum(intTri, v) < minAngleSum;
+      if (nearCone || !needsRefinement(f)) continue;
+      Vertex v = intTri.insertCircumcenterOrSplitSegment(f);
+      nInserted++;
+      for (Face g : v.adjacentFaces()) {
+        for (Edge e : g.adjacentEdges()) flipCandidates.push_back(e.getIndex());
+      }
+    }
+    flipCandidatesInRounds(intTri, flipCandidates, nThreads, flipStats, RoundControl(), flipLeftovers);
+
+    stats.nRounds++;
+    stats.nInsertions += nInserted;
+    if (nInserted == 0) break;
+    if (control.progress) control.progress(stats.nRounds, stats.nInsertions);
+    if (control.shouldStop()) {
+      stats.stoppedEarly = true;
+      return stats;
+    }
+  }
+
+  flipLeftoversToDelaunay(intTri, flipLeftovers);
+  return stats;
+}
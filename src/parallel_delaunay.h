@@ -0,0 +1,81 @@
+#pragma once
+
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+// Counts describing a run of flipToDelaunayInRounds()
+struct FlipRoundStats {
+  size_t nRounds = 0;
+  size_t nFlips = 0;
+  bool stoppedEarly = false; // stopped by its RoundControl before finishing
+};
+
+// Counts describing a run of delaunayRefineInRounds()
+struct RefineRoundStats {
+  size_t nRounds = 0;
+  size_t nInsertions = 0;
+  bool stoppedEarly = false; // stopped by its RoundControl before finishing
+};
+
+// Limits on a run of flipToDelaunayInRounds() or delaunayRefineInRounds(), and a way to follow its progress. Both are
+// checked between rounds, so a run always stops at a valid triangulation with every flip and insertion so far applied.
+struct RoundControl {
+  // Stop once a round ends after this time
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+  // Stop once a round ends after this becomes true, if given
+  const std::atomic<bool>* cancel = nullptr;
+
+  // Called after every round with the number of rounds and of flips or insertions so far, if set
+  std::function<void(size_t nRounds, size_t nChanges)> progress;
+
+  bool shouldStop() const {
+    return (cancel && cancel->load()) || std::chrono::steady_clock::now() >= deadline;
+  }
+};
+
+// Flip intTri to Delaunay in rounds. Each round tests the candidate edges concurrently on nThreads threads (0
+// means one per hardware thread), picks an independent set of non-Delaunay edges, no two of which share a triangle,
+// greedily in increasing edge index, and flips that set. The edges around each flip are candidates for the next
+// round, along with the edges deferred because a triangle was already claimed. The final triangulation depends only
+// on the input, never on the thread count.
+//
+// The flips themselves run through IntrinsicTriangulation::flipEdgeIfNotDelaunay(), one at a time: every flip updates
+// state geometry-central shares across the mesh (the halfedge of each vertex, and any quantities the triangulation
+// keeps up to date), so flips cannot be applied concurrently even when they share no triangle. What the rounds add
+// over flipToDelaunay() is a point between rounds where control can stop the run, at a valid triangulation. Edges the
+// rounds could not flip are then passed through a serial queue seeded with those edges alone, so the result is
+// Delaunay whenever the serial path's would be.
+//
+// If control stops the rounds early, the final queue is skipped, and the result need not be Delaunay.
+FlipRoundStats flipToDelaunayInRounds(geometrycentral::surface::IntrinsicTriangulation& intTri, size_t nThreads,
+                                      const RoundControl& control = RoundControl());
+
+// Refine intTri until every face has angles of at least angleThreshDegrees and a circumradius of at most
+// circumradiusThresh, or maxInsertions vertices have been inserted, in rounds. Each round tests every face
+// concurrently, picks the faces to refine largest first, skipping any whose neighbourhood (the faces around its
+// vertices) overlaps one already picked, inserts their circumcenters (or splits the boundary segment they encroach
+// on), and flips back to Delaunay around the new vertices with flipToDelaunayInRounds()'s rounds.
+//
+// This inserts batches of independent points rather than one point at a time, so the result differs from
+// delaunayRefine()'s, although it enforces the same bounds. Like the flips, the insertions themselves are serial, for
+// the same reason, so only the tests of each round run on nThreads threads. An insertion can reach beyond the
+// neighbourhood of its face, so a picked face which an earlier insertion in the round changed (as its halfedges,
+// vertices and edge lengths show) or deleted is left for the next round. The result depends only on the input, never
+// on the thread count.
+//
+// Every round tests every vertex and face again, so this does more work than delaunayRefine(), whose queue only
+// revisits the faces each insertion changed. As with the flips, what the rounds add is a point between rounds where
+// control can stop the run, at a valid triangulation; this is only used under a time budget or for cancellation.
+//
+// The initial flips to Delaunay count towards control's limits. If they stop the run early, every insertion made so
+// far is kept, and the flips after each round's insertions will have run to completion, but some faces may not meet
+// the bounds yet; the final queue over the edges the flips left is skipped, so if the initial flips were cut short the
+// result need not be Delaunay either.
+RefineRoundStats delaunayRefineInRounds(geometrycentral::surface::IntrinsicTriangulation& intTri,
+                                        double angleThreshDegrees, double circumradiusThresh, size_t maxInsertions,
+                                        size_t nThreads, const RoundControl& control = RoundControl());
@@ -0,0 +1,150 @@
+#include "regional_common_subdivision.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+RegionalCommonSubdivision::RegionalCommonSubdivision(IntrinsicTriangulation& intTri_)
+    : intTri(intTri_), paths(intTri_.mesh), stamps(intTri_.mesh), inRegion(intTri_.mesh, false) {}
+
+std::vector<Face> RegionalCommonSubdivision::intrinsicFacesOver(const std::vector<Face>& inputFaces) {
+  std::vector<Face> faces;
+  auto addFacesAround = [&](const SurfacePoint& p) {
+    switch (p.type) {
+    case SurfacePointType::Vertex:
+      for (Face f : p.vertex.adjacentFaces()) faces.push_back(f);
+      break;
+    case SurfacePointType::Edge:
+      for (Face f : p.edge.adjacentFaces()) faces.push_back(f);
+      break;
+    case SurfacePointType::Face:
+      faces.push_back(p.face);
+      break;
+    }
+  };
+
+  // Every input vertex is also an intrinsic vertex, so an intrinsic face overlapping an input face either has one of
+  // the input face's vertices as a corner, or is crossed by one of its edges
+  for (Face inputFace : inputFaces) {
+    for (Halfedge inputHe : inputFace.adjacentHalfedges()) {
+      for (const SurfacePoint& p : intTri.traceInputHalfedgeAlongIntrinsic(inputHe)) addFacesAround(p);
+    }
+  }
+
+  std::sort(faces.begin(), faces.end());
+  faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+  return faces;
+}
+
+void RegionalCommonSubdivision::addIntrinsicFaces(const std::vector<Face>& intrinsicFaces) {
+  for (Face f : intrinsicFaces) {
+    for (Edge e : f.adjacentEdges()) inRegion[e] = true;
+  }
+}
+
+size_t RegionalCommonSubdivision::update(size_t nThreads) {
+  std::vector<Edge> stale;
+  for (Edge e : regionEdges()) {
+    if (isStale(e)) stale.push_back(e);
+  }
+  if (stale.empty()) return 0;
+
+  // The backends compute some of the input geometry lazily on first use, which must not happen concurrently, so one
+  // edge is traced alone first. After that tracing only reads the triangulation, and each edge writes its own path.
+  trace(stale[0]);
+  parallelFor(
+      stale.size() - 1, [&](size_t iE) { trace(stale[iE + 1]); }, nThreads, 64);
+  nTraced += stale.size();
+  return stale.size();
+}
+
+size_t RegionalCommonSubdivision::nVertices() {
+  std::vector<Edge> edges = regionEdges();
+  VertexData<char> isEndpoint(intTri.mesh, false);
+  size_t n = 0;
+  for (Edge e : edges) {
+    for (Vertex v : {e.firstVertex(), e.secondVertex()}) {
+      if (!isEndpoint[v]) n++;
+      isEndpoint[v] = true;
+    }
+    n += edgePath(e).size() - 2;
+  }
+  return n;
+}
+
+RegionalCommonSubdivision::EdgeStamp RegionalCommonSubdivision::stampOf(Edge e) const {
+  EdgeStamp stamp;
+  stamp.tail = e.firstVertex().getIndex();
+  stamp.tip = e.secondVertex().getIndex();
+  stamp.length = intTri.intrinsicEdgeLengths[e];
+  return stamp;
+}
+
+void RegionalCommonSubdivision::trace(Edge e) {
+  paths[e] = intTri.traceIntrinsicHalfedgeAlongInput(e.halfedge());
+  stamps[e] = stampOf(e);
+}
+
+const std::vector<SurfacePoint>& RegionalCommonSubdivision::edgePath(Edge intrinsicEdge) {
+  if (isStale(intrinsicEdge)) {
+    trace(intrinsicEdge);
+    nTraced++;
+  }
+  return paths[intrinsicEdge];
+}
+
+std::vector<Edge> RegionalCommonSubdivision::regionEdges() const {
+  std::vector<Edge> edges;
+  for (Edge e : intTri.mesh.edges()) {
+    if (wholeMesh || inRegion[e]) edges.push_back(e);
+  }
+  return edges;
+}
+
+RegionalCommonSubdivision::Polylines RegionalCommonSubdivision::polylines(VertexPositionGeometry& inputGeometry) {
+  Polylines result;
+
+  // Nodes of the intrinsic vertices, added as they are first used
+  VertexData<size_t> node(intTri.mesh, INVALID_IND);
+  auto vertexNode = [&](Vertex v, const SurfacePoint& location) {
+    if (node[v] == INVALID_IND) {
+      node[v] = result.nodes.size();
+      result.nodes.push_back(location.interpolate(inputGeometry.inputVertexPositions));
+    }
+    return node[v];
+  };
+
+  for (Edge e : regionEdges()) {
+    const std::vector<SurfacePoint>& path = edgePath(e);
+    std::vector<size_t> line;
+    line.push_back(vertexNode(e.firstVertex(), path.front()));
+    for (size_t iP = 1; iP + 1 < path.size(); iP++) {
+      line.push_back(result.nodes.size());
+      result.nodes.push_back(path[iP].interpolate(inputGeometry.inputVertexPositions));
+    }
+    line.push_back(vertexNode(e.secondVertex(), path.back()));
+    result.lines.push_back(line);
+  }
+  return result;
+}
+
+std::string RegionalCommonSubdivision::encodeObj(VertexPositionGeometry& inputGeometry) {
+  Polylines lines = polylines(inputGeometry);
+  std::string out = "# common subdivision edges over " + std::to_string(lines.lines.size()) + " intrinsic edges\n";
+
+  char buf[128];
+  for (const Vector3& p : lines.nodes) {
+    int n = std::snprintf(buf, sizeof(buf), "v %.16g %.16g %.16g\n", p.x, p.y, p.z);
+    out.append(buf, n);
+  }
+  for (const std::vector<size_t>& line : lines.lines) {
+    out += "l";
+    for (size_t iN : line) out += " " + std::to_string(iN + 1);
+    out += "\n";
+  }
+  return out;
+}
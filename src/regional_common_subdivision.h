@@ -0,0 +1,103 @@
+#pragma once
+
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/surface_point.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <string>
+#include <vector>
+
+// The part of the common subdivision lying over a region of the surface, traced on demand.
+//
+// IntrinsicTriangulation::getCommonSubdivision() traces every intrinsic edge before anything can be queried. This
+// instead traces intrinsic edges one at a time as regions are added, caching each path, so the cost scales with the
+// regions asked for rather than with the whole mesh.
+//
+// The cache survives edits to the triangulation. Each path is stamped with the endpoints and length its edge had when
+// it was traced, and an edge whose stamp no longer matches (because it was flipped, or split, or is new) is traced
+// again when next used. update() re-traces every such edge of the region at once, so that after a local edit only the
+// edited neighbourhood is traced again.
+//
+// Only the edges of the common subdivision are built: each traced intrinsic edge is a path of points on the input
+// mesh, along which data on the input vertices can be interpolated (what CommonSubdivision::interpolateAcrossA() does
+// at the common subdivision's vertices). Building the faces of the common subdivision needs geometry-central's global
+// CommonSubdivision construction.
+class RegionalCommonSubdivision {
+public:
+  RegionalCommonSubdivision(geometrycentral::surface::IntrinsicTriangulation& intTri);
+
+  // Intrinsic faces overlapping any of the given input faces: the intrinsic faces around their vertices, and those
+  // crossed by their edges
+  std::vector<geometrycentral::surface::Face>
+  intrinsicFacesOver(const std::vector<geometrycentral::surface::Face>& inputFaces);
+
+  // Add intrinsic faces to the region. Their edges are traced by the next update(), or when first used.
+  void addIntrinsicFaces(const std::vector<geometrycentral::surface::Face>& intrinsicFaces);
+
+  // Make the region the whole surface, including edges created by later edits
+  void addAllFaces() { wholeMesh = true; }
+
+  // Trace every edge of the region whose path is missing or out of date, on nThreads threads (0 means one per hardware
+  // thread). Every edge is traced independently, so the paths do not depend on the thread count. Returns the number of
+  // edges traced.
+  size_t update(size_t nThreads = 1);
+
+  // The number of vertices of the common subdivision over the region's traced edges, as
+  // CommonSubdivision::nVertices() counts them for the whole mesh: the intrinsic vertices of the region's edges, plus
+  // every point where one of those edges crosses an input edge
+  size_t nVertices();
+
+  // The path of an intrinsic edge over the input mesh, from its first to its second vertex, traced if missing or out
+  // of date
+  const std::vector<geometrycentral::surface::SurfacePoint>& edgePath(geometrycentral::surface::Edge intrinsicEdge);
+
+  // Data on the input vertices, interpolated at every point of an intrinsic edge's path
+  template <typename T>
+  std::vector<T> interpolateAlongEdge(geometrycentral::surface::Edge intrinsicEdge,
+                                      const geometrycentral::surface::VertexData<T>& inputData) {
+    const std::vector<geometrycentral::surface::SurfacePoint>& path = edgePath(intrinsicEdge);
+    std::vector<T> values;
+    values.reserve(path.size());
+    for (const geometrycentral::surface::SurfacePoint& p : path) values.push_back(p.interpolate(inputData));
+    return values;
+  }
+
+  // The region's intrinsic edges, in increasing index order
+  std::vector<geometrycentral::surface::Edge> regionEdges() const;
+
+  // The number of times an edge has been traced, counting edges traced again after edits
+  size_t nTracedEdges() const { return nTraced; }
+
+  // The region's traced edges as polylines on the input surface, one per intrinsic edge in regionEdges() order. Each
+  // line lists indices into nodes; intrinsic vertices shared by several edges are a single node.
+  struct Polylines {
+    std::vector<geometrycentral::Vector3> nodes;
+    std::vector<std::vector<size_t>> lines;
+  };
+  Polylines polylines(geometrycentral::surface::VertexPositionGeometry& inputGeometry);
+
+  // The polylines as an OBJ file
+  std::string encodeObj(geometrycentral::surface::VertexPositionGeometry& inputGeometry);
+
+private:
+  // An intrinsic edge's endpoints and length, as they were when its path was traced
+  struct EdgeStamp {
+    size_t tail = geometrycentral::INVALID_IND;
+    size_t tip = geometrycentral::INVALID_IND;
+    double length = -1;
+    bool operator==(const EdgeStamp& other) const {
+      return tail == other.tail && tip == other.tip && length == other.length;
+    }
+  };
+  EdgeStamp stampOf(geometrycentral::surface::Edge e) const;
+  void trace(geometrycentral::surface::Edge e);
+  bool isStale(geometrycentral::surface::Edge e) const { return !(stamps[e] == stampOf(e)); }
+
+  geometrycentral::surface::IntrinsicTriangulation& intTri;
+  geometrycentral::surface::EdgeData<std::vector<geometrycentral::surface::SurfacePoint>> paths;
+  geometrycentral::surface::EdgeData<EdgeStamp> stamps;
+  geometrycentral::surface::EdgeData<char> inRegion;
+  bool wholeMesh = false;
+  size_t nTraced = 0;
+};
@@ -0,0 +1,96 @@
+#include "subdivision_view.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+std::vector<uint8_t> subdivisionFaceColors(CommonSubdivision& cs, bool fromInput, int kColors) {
+  if (!cs.mesh) throw std::runtime_error("subdivisionFaceColors: the common subdivision has no mesh");
+  ManifoldSurfaceMesh& source = fromInput ? cs.meshA : cs.meshB;
+  const FaceData<Face>& sourceFace = fromInput ? cs.sourceFaceA : cs.sourceFaceB;
+
+  FaceData<double> sourceColors = niceColors(source, kColors);
+  std::vector<uint8_t> colors;
+  colors.reserve(cs.mesh->nFaces());
+  for (Face f : cs.mesh->faces()) colors.push_back(static_cast<uint8_t>(sourceColors[sourceFace[f]]));
+  return colors;
+}
+
+std::vector<std::array<size_t, 3>> triangleIndices(ManifoldSurfaceMesh& mesh) {
+  VertexData<size_t> vIdx = mesh.getVertexIndices();
+  std::vector<std::array<size_t, 3>> triangles;
+  triangles.reserve(mesh.nFaces());
+  for (Face f : mesh.faces()) {
+    if (!f.isTriangle()) throw std::runtime_error("triangleIndices: mesh has a face which is not a triangle");
+    Halfedge he = f.halfedge();
+    triangles.push_back({{vIdx[he.tailVertex()], vIdx[he.next().tailVertex()], vIdx[he.next().next().tailVertex()]}});
+  }
+  return triangles;
+}
+
+RegionalCommonSubdivision::Polylines intrinsicEdgePolylines(CommonSubdivision& cs,
+                                                             const VertexData<Vector3>& inputPositions) {
+  RegionalCommonSubdivision::Polylines result;
+
+  // Nodes of the intrinsic vertices, added as they are first used
+  VertexData<size_t> node(cs.meshB, INVALID_IND);
+  auto vertexNode = [&](Vertex v, const SurfacePoint& location) {
+    if (node[v] == INVALID_IND) {
+      node[v] = result.nodes.size();
+      result.nodes.push_back(location.interpolate(inputPositions));
+    }
+    return node[v];
+  };
+
+  result.lines.reserve(cs.meshB.nEdges());
+  for (Edge e : cs.meshB.edges()) {
+    const std::vector<CommonSubdivisionPoint*>& points = cs.pointsAlongB[e];
+    std::vector<size_t> line;
+    line.reserve(points.size());
+    line.push_back(vertexNode(e.firstVertex(), points.front()->posA));
+    for (size_t iP = 1; iP + 1 < points.size(); iP++) {
+      line.push_back(result.nodes.size());
+      result.nodes.push_back(points[iP]->posA.interpolate(inputPositions));
+    }
+    line.push_back(vertexNode(e.secondVertex(), points.back()->posA));
+    result.lines.push_back(line);
+  }
+  return result;
+}
+
+CurveBuffers decimatePolylines(const RegionalCommonSubdivision::Polylines& polylines, size_t maxNodes) {
+  size_t nInterior = 0;
+  for (const std::vector<size_t>& line : polylines.lines) {
+    if (line.size() > 2) nInterior += line.size() - 2;
+  }
+  // Polylines share the nodes of their endpoints, while each interior node belongs to one polyline
+  size_t nEndpoints = polylines.nodes.size() - nInterior;
+  size_t interiorBudget = maxNodes > nEndpoints ? maxNodes - nEndpoints : 0;
+  size_t stride = interiorBudget == 0 ? nInterior + 1
+                                      : std::max<size_t>((nInterior + interiorBudget - 1) / interiorBudget, 1);
+
+  // Copy only the nodes which are kept, in the order they are first used
+  CurveBuffers buffers;
+  std::vector<size_t> kept(polylines.nodes.size(), INVALID_IND);
+  auto keep = [&](size_t iNode) {
+    if (kept[iNode] == INVALID_IND) {
+      kept[iNode] = buffers.nodes.size();
+      buffers.nodes.push_back(polylines.nodes[iNode]);
+    }
+    return kept[iNode];
+  };
+
+  for (const std::vector<size_t>& line : polylines.lines) {
+    if (line.size() < 2) continue;
+    size_t prev = keep(line.front());
+    for (size_t iN = stride; iN + 1 < line.size(); iN += stride) {
+      size_t next = keep(line[iN]);
+      buffers.segments.push_back({{prev, next}});
+      prev = next;
+    }
+    buffers.segments.push_back({{prev, keep(line.back())}});
+  }
+  return buffers;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "geometrycentral/surface/common_subdivision.h"
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+
+#include "regional_common_subdivision.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Flat buffers for showing large intrinsic triangulations and common subdivisions in the viewer. These do not depend
+// on polyscope; each buffer is laid out as polyscope (or a GPU vertex or index buffer) takes it, so it can be uploaded
+// without another per-element copy.
+
+// The color of every face of the common subdivision's mesh, in mesh order: the niceColors() index, below kColors, of
+// the face of the intrinsic mesh (or with fromInput, the input mesh) it lies in. This is one byte per face, where
+// copyFromB(niceColors(meshB)) takes eight.
+std::vector<uint8_t> subdivisionFaceColors(geometrycentral::surface::CommonSubdivision& cs, bool fromInput,
+                                           int kColors = 7);
+
+// The vertex indices of every face of a triangle mesh, in mesh order. Throws if any face is not a triangle.
+std::vector<std::array<size_t, 3>> triangleIndices(geometrycentral::surface::ManifoldSurfaceMesh& mesh);
+
+// The intrinsic edges of a traced common subdivision, as polylines over the input surface through the points where
+// they cross it. Unlike RegionalCommonSubdivision::polylines(), this needs no tracing of its own.
+RegionalCommonSubdivision::Polylines
+intrinsicEdgePolylines(geometrycentral::surface::CommonSubdivision& cs,
+                       const geometrycentral::surface::VertexData<geometrycentral::Vector3>& inputPositions);
+
+// A curve network: node positions, and pairs of node indices
+struct CurveBuffers {
+  std::vector<geometrycentral::Vector3> nodes;
+  std::vector<std::array<size_t, 2>> segments;
+};
+
+// Segments along the polylines, thinned out to at most about maxNodes nodes. Every polyline keeps its endpoints, so
+// the result only exceeds maxNodes if they alone do, and its interior nodes are kept at a common stride.
+CurveBuffers decimatePolylines(const RegionalCommonSubdivision::Polylines& polylines, size_t maxNodes);
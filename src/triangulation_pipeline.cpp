@@ -0,0 +1,204 @@
+#include "triangulation_pipeline.h"
+
+#include "geometrycentral/surface/integer_coordinates_intrinsic_triangulation.h"
+#include "geometrycentral/surface/signpost_intrinsic_triangulation.h"
+
+#include "mesh_loading.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+std::unique_ptr<IntrinsicTriangulation> makeIntrinsicTriangulation(std::string backend, ManifoldSurfaceMesh& mesh,
+                                                                   VertexPositionGeometry& geometry) {
+  if (backend == "Integer Coordinates") {
+    return std::unique_ptr<IntrinsicTriangulation>(new IntegerCoordinatesIntrinsicTriangulation(mesh, geometry));
+  } else if (backend == "Signposts") {
+    return std::unique_ptr<IntrinsicTriangulation>(new SignpostIntrinsicTriangulation(mesh, geometry));
+  }
+  throw std::runtime_error("unrecognized backend '" + backend + "'");
+}
+
+void TriangulationPipeline::loadMesh(std::string filename, bool triangulate, std::string cacheDir) {
+  dropTriangulation();
+  std::tie(mesh, geometry) = loadManifoldMesh(filename, triangulate, cacheDir, nThreads);
+}
+
+void TriangulationPipeline::setMesh(const double* vertexPositions, size_t nVertices, const size_t* triangles,
+                                    size_t nTriangles) {
+  std::vector<Vector3> positions(nVertices);
+  for (size_t iV = 0; iV < nVertices; iV++) {
+    positions[iV] = Vector3{vertexPositions[3 * iV], vertexPositions[3 * iV + 1], vertexPositions[3 * iV + 2]};
+  }
+  std::vector<std::vector<size_t>> polygons(nTriangles);
+  for (size_t iF = 0; iF < nTriangles; iF++) {
+    polygons[iF] = {triangles[3 * iF], triangles[3 * iF + 1], triangles[3 * iF + 2]};
+    for (size_t iV : polygons[iF]) {
+      if (iV >= nVertices) {
+        throw std::runtime_error("triangle " + std::to_string(iF) + " has vertex index " + std::to_string(iV) +
+                                 ", but there are only " + std::to_string(nVertices) + " vertices");
+      }
+    }
+  }
+
+  dropTriangulation();
+  std::tie(mesh, geometry) = makeManifoldMesh(polygons, positions, nThreads);
+}
+
+void TriangulationPipeline::clear() {
+  dropTriangulation();
+  geometry.reset();
+  mesh.reset();
+}
+
+void TriangulationPipeline::dropTriangulation() {
+  assembler.reset();
+  intTri.reset();
+  restored.reset();
+  lastFlipStatus.clear();
+  lastRefineStatus.clear();
+}
+
+void TriangulationPipeline::resetTriangulation(std::string backend_) {
+  inputMesh();
+  dropTriangulation();
+  intTri = makeIntrinsicTriangulation(backend_, *mesh, *geometry);
+  backend = backend_;
+}
+
+void TriangulationPipeline::saveTriangulation(std::string filename) {
+  saveIntrinsicTriangulation(filename, intrinsicTriangulation(), *geometry);
+}
+
+void TriangulationPipeline::loadTriangulation(std::string filename) {
+  std::unique_ptr<RestoredTriangulation> loaded = loadIntrinsicTriangulation(filename, inputMesh(), *geometry);
+  dropTriangulation();
+  restored = std::move(loaded);
+}
+
+std::unique_ptr<IntrinsicTriangulation> TriangulationPipeline::releaseTriangulation() {
+  intrinsicTriangulation();
+  assembler.reset();
+  lastFlipStatus.clear();
+  lastRefineStatus.clear();
+  return std::move(intTri);
+}
+
+void TriangulationPipeline::setTriangulation(std::unique_ptr<IntrinsicTriangulation> tri, std::string backend_) {
+  if (!tri || &tri->inputMesh != &inputMesh()) {
+    throw std::invalid_argument("the triangulation is not one of this pipeline's input mesh");
+  }
+  dropTriangulation();
+  intTri = std::move(tri);
+  backend = backend_;
+}
+
+size_t TriangulationPipeline::nVertices() const {
+  if (restored) return restored->mesh->nVertices();
+  return intTri ? intTri->mesh.nVertices() : 0;
+}
+
+size_t TriangulationPipeline::nFaces() const {
+  if (restored) return restored->mesh->nFaces();
+  return intTri ? intTri->mesh.nFaces() : 0;
+}
+
+ManifoldSurfaceMesh& TriangulationPipeline::inputMesh() {
+  if (!mesh) throw std::runtime_error("no input mesh has been loaded");
+  return *mesh;
+}
+
+VertexPositionGeometry& TriangulationPipeline::inputGeometry() {
+  inputMesh();
+  return *geometry;
+}
+
+IntrinsicTriangulation& TriangulationPipeline::intrinsicTriangulation() {
+  if (restored) throw std::logic_error("a loaded triangulation cannot be edited; reset the triangulation first");
+  if (!intTri) resetTriangulation(backend);
+  return *intTri;
+}
+
+IntrinsicView TriangulationPipeline::intrinsicView() {
+  if (restored) return IntrinsicView{*restored->mesh, *restored->geometry, restored->vertexLocations};
+  IntrinsicTriangulation& tri = intrinsicTriangulation();
+  return IntrinsicView{tri.mesh, tri, tri.vertexLocations};
+}
+
+RoundControl TriangulationPipeline::roundControl(double timeBudget, std::string changes) const {
+  RoundControl control;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (timeBudget < std::numeric_limits<double>::infinity()) {
+    std::chrono::duration<double> budget(timeBudget);
+    control.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget);
+  }
+  control.cancel = cancel;
+  if (progress) {
+    std::function<void(const std::string&, size_t, size_t, double)> report = progress;
+    control.progress = [=](size_t nRounds, size_t nChanges) {
+      report(changes, nRounds, nChanges,
+             std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    };
+  }
+  return control;
+}
+
+std::string TriangulationPipeline::roundStatus(bool stoppedEarly) const {
+  if (!stoppedEarly) return "complete";
+  return cancel && cancel->load() ? "interrupted" : "timeBudget";
+}
+
+FlipRoundStats TriangulationPipeline::flipToDelaunay() {
+  IntrinsicTriangulation& tri = intrinsicTriangulation();
+  FlipRoundStats stats;
+  if (flipsInRounds()) {
+    // Flips are serial either way, so the rounds need only one thread for their tests
+    stats = flipToDelaunayInRounds(tri, 1, roundControl(flipTimeBudget, "flips"));
+  } else {
+    tri.flipToDelaunay();
+  }
+  lastFlipStatus = roundStatus(stats.stoppedEarly);
+  return stats;
+}
+
+RefineRoundStats TriangulationPipeline::refineDelaunay(double angleThreshDegrees, double circumradiusThresh,
+                                                       size_t maxInsertions) {
+  IntrinsicTriangulation& tri = intrinsicTriangulation();
+  RefineRoundStats stats;
+  if (refinesInRounds()) {
+    stats = delaunayRefineInRounds(tri, angleThreshDegrees, circumradiusThresh, maxInsertions, nThreads,
+                                   roundControl(refineTimeBudget, "insertions"));
+  } else {
+    tri.delaunayRefine(angleThreshDegrees, circumradiusThresh, maxInsertions);
+  }
+  lastRefineStatus = roundStatus(stats.stoppedEarly);
+  return stats;
+}
+
+LaplacianAssembler& TriangulationPipeline::laplacianAssembler() {
+  if (!assembler) {
+    IntrinsicView view = intrinsicView();
+    assembler.reset(new LaplacianAssembler(view.mesh, view.geometry.inputEdgeLengths));
+  }
+  return *assembler;
+}
+
+const IntrinsicOutputBuffers& TriangulationPipeline::assemble(const IntrinsicOutputs& request) {
+  assembleIntrinsicOutputs(intrinsicView(), geometry->inputVertexPositions, request, buffers, nThreads);
+  if (request.laplaceMat || request.massMat) laplacianAssembler().update(nThreads);
+  return buffers;
+}
+
+const Eigen::SparseMatrix<double, Eigen::RowMajor>& TriangulationPipeline::laplacian() const {
+  if (!assembler) throw std::runtime_error("the Laplacian has not been assembled");
+  return assembler->laplacian();
+}
+
+const Eigen::SparseMatrix<double, Eigen::RowMajor>& TriangulationPipeline::lumpedMass() const {
+  if (!assembler) throw std::runtime_error("the mass matrix has not been assembled");
+  return assembler->lumpedMass();
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include "intrinsic_outputs.h"
+#include "laplacian_assembly.h"
+#include "parallel_delaunay.h"
+#include "triangulation_state.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+
+// A new intrinsic triangulation of the input mesh, with the given backend ("Integer Coordinates" or "Signposts").
+// Throws on any other backend.
+std::unique_ptr<geometrycentral::surface::IntrinsicTriangulation>
+makeIntrinsicTriangulation(std::string backend, geometrycentral::surface::ManifoldSurfaceMesh& mesh,
+                           geometrycentral::surface::VertexPositionGeometry& geometry);
+
+// One mesh's trip through the stages the int_tri executable runs: load an input mesh, build an intrinsic
+// triangulation of it, flip and refine it, and assemble its outputs in memory. The executable itself runs each mesh
+// through one of these.
+//
+// A pipeline owns all of its state, so several can run at once on different threads; each one must only be used from
+// one thread at a time, apart from *cancel. Every method throws std::runtime_error (or another std::exception) on
+// failure.
+class TriangulationPipeline {
+public:
+  // Threads used by parallel loops within each stage, or 0 for one per hardware thread
+  size_t nThreads = 0;
+
+  // Limits on flips and refinement, in seconds from the start of each. A finite budget runs that stage in rounds, as
+  // flipToDelaunayInRounds() and delaunayRefineInRounds() describe, which stop at the end of the first round past it.
+  double flipTimeBudget = std::numeric_limits<double>::infinity();
+  double refineTimeBudget = std::numeric_limits<double>::infinity();
+
+  // If set, flips and refinement in rounds also stop at the end of the first round after this becomes true. It may be
+  // set from any thread.
+  const std::atomic<bool>* cancel = nullptr;
+
+  // If set, called after every round of flips or refinement with "flips" or "insertions", the number of rounds and of
+  // those changes so far, and the seconds since the stage started
+  std::function<void(const std::string& changes, size_t nRounds, size_t nChanges, double seconds)> progress;
+
+  // Replace the input mesh, dropping any triangulation of the previous one. setMesh() takes 3 coordinates per vertex
+  // and 3 vertex indices per triangle.
+  void loadMesh(std::string filename, bool triangulate = false, std::string cacheDir = "");
+  void setMesh(const double* vertexPositions, size_t nVertices, const size_t* triangles, size_t nTriangles);
+
+  // Drop the input mesh and everything built from it
+  void clear();
+
+  // Start over from the input mesh, with an intrinsic triangulation using the given backend ("Integer Coordinates"
+  // or "Signposts")
+  void resetTriangulation(std::string backend = "Integer Coordinates");
+
+  // Save the intrinsic triangulation, or replace it with one saved for the same input mesh, as --saveTriangulation and
+  // --loadTriangulation do. A loaded triangulation only has its outputs; it cannot be flipped or refined, and
+  // intrinsicTriangulation() throws until the next resetTriangulation().
+  void saveTriangulation(std::string filename);
+  void loadTriangulation(std::string filename);
+
+  // Take the intrinsic triangulation out of the pipeline, or put one of the input mesh in, e.g. to keep the better of
+  // two backends' triangulations. Putting one in forgets the last flip and refinement statuses.
+  std::unique_ptr<geometrycentral::surface::IntrinsicTriangulation> releaseTriangulation();
+  void setTriangulation(std::unique_ptr<geometrycentral::surface::IntrinsicTriangulation> tri, std::string backend);
+
+  // Flip to Delaunay, and refine, as --flipDelaunay and --refineDelaunay do. When a stage runs in rounds (see
+  // flipsInRounds() and refinesInRounds()), its stats are filled in, and it may stop early at the limits above.
+  FlipRoundStats flipToDelaunay();
+  RefineRoundStats refineDelaunay(double angleThreshDegrees = 25.,
+                                  double circumradiusThresh = std::numeric_limits<double>::infinity(),
+                                  size_t maxInsertions = geometrycentral::INVALID_IND);
+  bool flipsInRounds() const { return flipTimeBudget < std::numeric_limits<double>::infinity(); }
+  bool refinesInRounds() const { return refineTimeBudget < std::numeric_limits<double>::infinity(); }
+
+  // How the last flips and refinement ended: "complete", "timeBudget" or "interrupted" (by *cancel), or "" if they have
+  // not run on this triangulation
+  const std::string& flipStatus() const { return lastFlipStatus; }
+  const std::string& refineStatus() const { return lastRefineStatus; }
+
+  // Sizes of the input mesh and the intrinsic triangulation, or 0 if there is none yet
+  size_t nInputVertices() const { return mesh ? mesh->nVertices() : 0; }
+  size_t nVertices() const;
+  size_t nFaces() const;
+  bool hasTriangulation() const { return intTri || restored; }
+
+  // The input mesh and its geometry, throwing if there is none, and the intrinsic triangulation, created with the
+  // last backend given to resetTriangulation() if there is none
+  geometrycentral::surface::ManifoldSurfaceMesh& inputMesh();
+  geometrycentral::surface::VertexPositionGeometry& inputGeometry();
+  geometrycentral::surface::IntrinsicTriangulation& intrinsicTriangulation();
+
+  // The triangulation whose outputs are assembled: the intrinsic triangulation, or one loaded with loadTriangulation()
+  IntrinsicView intrinsicView();
+
+  // The Laplacian assembler of that triangulation, created on first use. It is kept up to date across flips and
+  // refinement, recomputing only the rows around changed faces, but replaced along with the triangulation.
+  LaplacianAssembler& laplacianAssembler();
+
+  // Assemble the requested outputs. The buffers and matrices stay valid, and unchanged, until the next call to any
+  // method other than an accessor.
+  const IntrinsicOutputBuffers& assemble(const IntrinsicOutputs& request);
+  const IntrinsicOutputBuffers& outputs() const { return buffers; }
+  const Eigen::SparseMatrix<double, Eigen::RowMajor>& laplacian() const;
+  const Eigen::SparseMatrix<double, Eigen::RowMajor>& lumpedMass() const;
+
+private:
+  std::unique_ptr<geometrycentral::surface::ManifoldSurfaceMesh> mesh;
+  std::unique_ptr<geometrycentral::surface::VertexPositionGeometry> geometry;
+  std::unique_ptr<geometrycentral::surface::IntrinsicTriangulation> intTri;
+  std::unique_ptr<RestoredTriangulation> restored;
+  std::unique_ptr<LaplacianAssembler> assembler;
+  IntrinsicOutputBuffers buffers;
+  std::string backend = "Integer Coordinates";
+  std::string lastFlipStatus, lastRefineStatus;
+
+  // Drop the triangulation, and everything built from it
+  void dropTriangulation();
+
+  // The limits for a stage in rounds, starting now
+  RoundControl roundControl(double timeBudget, std::string changes) const;
+  std::string roundStatus(bool stoppedEarly) const;
+};
@@ -0,0 +1,222 @@
+#include "triangulation_state.h"
+
+#include "async_writer.h"
+#include "content_hash.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+using namespace geometrycentral;
+using namespace geometrycentral::surface;
+
+// == File format
+//
+// Raw arrays in the host's byte order (the header records it, and files from a host with a different byte order are
+// rejected):
+//
+//   char[8]   magic "ITINTRI\0"
+//   uint32    format version (currently 1), uint32 byte order marker 0x01020304
+//   uint32    reserved (0), uint32 reserved (0)
+//   uint64    input vertex count, input face count, hash of the input vertex positions
+//   uint64    intrinsic vertex count nV, intrinsic face count nF
+//   uint64    faceVertices[3 * nF]
+//   uint64    twins[3 * nF]      (the side 3 * face + corner of each face side's twin, or UINT64_MAX on the boundary)
+//   double    sideLengths[3 * nF]
+//   per intrinsic vertex: uint32 location type (0 vertex, 1 edge, 2 face), uint32 padding, uint64 input element index,
+//                         double[3] coordinates (tEdge, or barycentric coordinates in the face)
+//
+// Side c of face f runs from faceVertices[3 * f + c] to faceVertices[3 * f + (c + 1) % 3].
+
+namespace {
+
+const char TRIANGULATION_MAGIC[8] = {'I', 'T', 'I', 'N', 'T', 'R', 'I', 0};
+const uint32_t TRIANGULATION_VERSION = 1;
+const uint32_t TRIANGULATION_BYTE_ORDER = 0x01020304;
+const size_t TRIANGULATION_HEADER_SIZE = 64;
+const size_t VERTEX_LOCATION_SIZE = 40;
+
+// FNV-1a hash of the input vertex positions, to check that a triangulation is loaded onto the mesh it was saved for
+uint64_t hashPositions(ManifoldSurfaceMesh& mesh, VertexPositionGeometry& geometry) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  for (Vertex v : mesh.vertices()) {
+    const Vector3& p = geometry.inputVertexPositions[v];
+    double xyz[3] = {p.x, p.y, p.z};
+    hash = fnv1aHash(xyz, sizeof(xyz), hash);
+  }
+  return hash;
+}
+
+template <typename T>
+void appendRaw(std::string& out, const T* data, size_t n) {
+  out.append(reinterpret_cast<const char*>(data), n * sizeof(T));
+}
+
+template <typename T>
+T readRaw(const char* array, size_t i) {
+  T val;
+  std::memcpy(&val, array + i * sizeof(T), sizeof(T));
+  return val;
+}
+
+} // namespace
+
+void saveIntrinsicTriangulation(std::string filename, IntrinsicTriangulation& intTri,
+                                VertexPositionGeometry& inputGeometry) {
+  ManifoldSurfaceMesh& mesh = *intTri.intrinsicMesh;
+  ManifoldSurfaceMesh& inputMesh = intTri.inputMesh;
+  intTri.requireVertexIndices();
+  intTri.requireEdgeLengths();
+
+  // Number the face sides, so that twins can be stored by side
+  HalfedgeData<size_t> sideIndex(mesh, INVALID_IND);
+  std::vector<Halfedge> sides;
+  sides.reserve(3 * mesh.nFaces());
+  for (Face f : mesh.faces()) {
+    Halfedge he = f.halfedge();
+    for (int c = 0; c < 3; c++) {
+      sideIndex[he] = sides.size();
+      sides.push_back(he);
+      he = he.next();
+    }
+  }
+
+  size_t nSides = sides.size();
+  std::vector<uint64_t> faceVertices(nSides), twins(nSides);
+  std::vector<double> sideLengths(nSides);
+  for (size_t iS = 0; iS < nSides; iS++) {
+    Halfedge he = sides[iS];
+    faceVertices[iS] = intTri.vertexIndices[he.vertex()];
+    twins[iS] = he.twin().isInterior() ? sideIndex[he.twin()] : UINT64_MAX;
+    sideLengths[iS] = intTri.edgeLengths[he.edge()];
+  }
+
+  std::string out;
+  out.append(TRIANGULATION_MAGIC, 8);
+  uint32_t flags[4] = {TRIANGULATION_VERSION, TRIANGULATION_BYTE_ORDER, 0, 0};
+  appendRaw(out, flags, 4);
+  uint64_t counts[5] = {inputMesh.nVertices(), inputMesh.nFaces(), hashPositions(inputMesh, inputGeometry),
+                        mesh.nVertices(), mesh.nFaces()};
+  appendRaw(out, counts, 5);
+  appendRaw(out, faceVertices.data(), nSides);
+  appendRaw(out, twins.data(), nSides);
+  appendRaw(out, sideLengths.data(), nSides);
+
+  // Vertex locations, in the order of the intrinsic vertex indices
+  std::vector<char> locations(VERTEX_LOCATION_SIZE * mesh.nVertices(), 0);
+  for (Vertex v : mesh.vertices()) {
+    const SurfacePoint& p = intTri.vertexLocations[v];
+    uint32_t type = static_cast<uint32_t>(p.type);
+    uint64_t element = 0;
+    double coords[3] = {0., 0., 0.};
+    switch (p.type) {
+    case SurfacePointType::Vertex:
+      element = p.vertex.getIndex();
+      break;
+    case SurfacePointType::Edge:
+      element = p.edge.getIndex();
+      coords[0] = p.tEdge;
+      break;
+    case SurfacePointType::Face:
+      element = p.face.getIndex();
+      coords[0] = p.faceCoords.x;
+      coords[1] = p.faceCoords.y;
+      coords[2] = p.faceCoords.z;
+      break;
+    }
+    char* dest = &locations[VERTEX_LOCATION_SIZE * intTri.vertexIndices[v]];
+    std::memcpy(dest, &type, sizeof(type));
+    std::memcpy(dest + 8, &element, sizeof(element));
+    std::memcpy(dest + 16, coords, sizeof(coords));
+  }
+  out.append(locations.data(), locations.size());
+
+  AsyncFileWriter::writeFile(filename, out);
+}
+
+std::unique_ptr<RestoredTriangulation> loadIntrinsicTriangulation(std::string filename, ManifoldSurfaceMesh& inputMesh,
+                                                                  VertexPositionGeometry& inputGeometry) {
+  MappedFile file(filename);
+  const char* data = file.data();
+  auto invalid = [&](std::string reason) {
+    return std::runtime_error("invalid triangulation file " + filename + ": " + reason);
+  };
+
+  if (file.size() < TRIANGULATION_HEADER_SIZE || std::memcmp(data, TRIANGULATION_MAGIC, 8) != 0) {
+    throw invalid("not a triangulation file");
+  }
+  uint32_t flags[4];
+  uint64_t counts[5];
+  std::memcpy(flags, data + 8, sizeof(flags));
+  std::memcpy(counts, data + 24, sizeof(counts));
+  if (flags[0] != TRIANGULATION_VERSION) throw invalid("unsupported version " + std::to_string(flags[0]));
+  if (flags[1] != TRIANGULATION_BYTE_ORDER) throw invalid("written on a host with a different byte order");
+  if (counts[0] != inputMesh.nVertices() || counts[1] != inputMesh.nFaces() ||
+      counts[2] != hashPositions(inputMesh, inputGeometry)) {
+    throw invalid("saved for a different input mesh");
+  }
+
+  size_t nV = counts[3];
+  size_t nF = counts[4];
+  size_t nSides = 3 * nF;
+  size_t expectedSize = TRIANGULATION_HEADER_SIZE + nSides * (2 * sizeof(uint64_t) + sizeof(double)) +
+                        nV * VERTEX_LOCATION_SIZE;
+  if (file.size() != expectedSize) throw invalid("wrong size");
+
+  const char* faceVertices = data + TRIANGULATION_HEADER_SIZE;
+  const char* twins = faceVertices + nSides * sizeof(uint64_t);
+  const char* sideLengths = twins + nSides * sizeof(uint64_t);
+  const char* locations = sideLengths + nSides * sizeof(double);
+
+  std::vector<std::vector<size_t>> polygons(nF, std::vector<size_t>(3));
+  std::vector<std::vector<std::tuple<size_t, size_t>>> polygonTwins(nF, std::vector<std::tuple<size_t, size_t>>(3));
+  for (size_t iS = 0; iS < nSides; iS++) {
+    uint64_t vert = readRaw<uint64_t>(faceVertices, iS);
+    uint64_t twin = readRaw<uint64_t>(twins, iS);
+    if (vert >= nV || (twin != UINT64_MAX && twin >= nSides)) throw invalid("index out of range");
+    polygons[iS / 3][iS % 3] = vert;
+    polygonTwins[iS / 3][iS % 3] =
+        twin == UINT64_MAX ? std::make_tuple(INVALID_IND, INVALID_IND) : std::make_tuple(twin / 3, twin % 3);
+  }
+
+  std::unique_ptr<RestoredTriangulation> restored(new RestoredTriangulation());
+  restored->mesh.reset(new ManifoldSurfaceMesh(polygons, polygonTwins));
+  ManifoldSurfaceMesh& mesh = *restored->mesh;
+
+  // The mesh numbers its faces and vertices in the order given
+  EdgeData<double> edgeLengths(mesh);
+  for (size_t iF = 0; iF < nF; iF++) {
+    Halfedge he = mesh.face(iF).halfedge();
+    for (int c = 0; c < 3 && he.vertex().getIndex() != polygons[iF][0]; c++) he = he.next();
+    for (int c = 0; c < 3; c++) {
+      edgeLengths[he.edge()] = readRaw<double>(sideLengths, 3 * iF + c);
+      he = he.next();
+    }
+  }
+  restored->geometry.reset(new EdgeLengthGeometry(mesh, edgeLengths));
+
+  restored->vertexLocations = VertexData<SurfacePoint>(mesh);
+  for (size_t iV = 0; iV < nV; iV++) {
+    const char* loc = locations + VERTEX_LOCATION_SIZE * iV;
+    uint32_t type = readRaw<uint32_t>(loc, 0);
+    uint64_t element = readRaw<uint64_t>(loc + 8, 0);
+    double coords[3];
+    std::memcpy(coords, loc + 16, sizeof(coords));
+
+    SurfacePoint p;
+    if (type == 0 && element < inputMesh.nVertices()) {
+      p = SurfacePoint(inputMesh.vertex(element));
+    } else if (type == 1 && element < inputMesh.nEdges()) {
+      p = SurfacePoint(inputMesh.edge(element), coords[0]);
+    } else if (type == 2 && element < inputMesh.nFaces()) {
+      p = SurfacePoint(inputMesh.face(element), Vector3{coords[0], coords[1], coords[2]});
+    } else {
+      throw invalid("bad vertex location");
+    }
+    restored->vertexLocations[mesh.vertex(iV)] = p;
+  }
+
+  return restored;
+}
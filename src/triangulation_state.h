@@ -0,0 +1,37 @@
+#pragma once
+
+#include "geometrycentral/surface/intrinsic_triangulation.h"
+#include "geometrycentral/surface/manifold_surface_mesh.h"
+#include "geometrycentral/surface/surface_point.h"
+#include "geometrycentral/surface/vertex_position_geometry.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// An intrinsic triangulation loaded from a file written by saveIntrinsicTriangulation().
+//
+// geometry-central can only construct its intrinsic triangulations from an input mesh, so a loaded triangulation is
+// not an IntrinsicTriangulation: it holds the intrinsic mesh, its edge lengths and the location of each intrinsic
+// vertex on the input mesh, which is everything the outputs computed from the intrinsic mesh alone need. Outputs which
+// trace the triangulation over the input (the common subdivision and function transfer) are not available, since
+// geometry-central cannot resume tracing from a saved triangulation either: its integer coordinates backend always
+// starts from a copy of the input mesh, so a loaded mesh could only be reached by replaying every flip and insertion.
+struct RestoredTriangulation {
+  std::unique_ptr<geometrycentral::surface::ManifoldSurfaceMesh> mesh;
+  std::unique_ptr<geometrycentral::surface::EdgeLengthGeometry> geometry;
+
+  // Points on the input mesh
+  geometrycentral::surface::VertexData<geometrycentral::surface::SurfacePoint> vertexLocations;
+};
+
+// Write the state of an intrinsic triangulation of inputMesh to a binary file: the intrinsic faces and their twins, the
+// intrinsic edge lengths, and the vertex locations on the input mesh. Throws on failure.
+void saveIntrinsicTriangulation(std::string filename, geometrycentral::surface::IntrinsicTriangulation& intTri,
+                                geometrycentral::surface::VertexPositionGeometry& inputGeometry);
+
+// Load a triangulation written by saveIntrinsicTriangulation(). Throws if the file is invalid, or if it was saved for a
+// different input mesh.
+std::unique_ptr<RestoredTriangulation>
+loadIntrinsicTriangulation(std::string filename, geometrycentral::surface::ManifoldSurfaceMesh& inputMesh,
+                           geometrycentral::surface::VertexPositionGeometry& inputGeometry);
@@ -0,0 +1,74 @@
+#include "work_stealing_pool.h"
+
+#include <iostream>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(size_t nWorkers) {
+  if (nWorkers == 0) nWorkers = 1;
+  for (size_t iW = 0; iW < nWorkers; iW++) {
+    workers.emplace_back(new Worker());
+  }
+}
+
+size_t WorkStealingPool::nWorkers() const { return workers.size(); }
+
+void WorkStealingPool::push(size_t iWorker, std::function<void()> job) {
+  Worker& w = *workers[iWorker % workers.size()];
+  std::lock_guard<std::mutex> lock(w.mutex);
+  w.jobs.push_back(std::move(job));
+}
+
+void WorkStealingPool::pushRoundRobin(std::vector<std::function<void()>> jobs) {
+  for (size_t iJ = 0; iJ < jobs.size(); iJ++) {
+    push(iJ % workers.size(), std::move(jobs[iJ]));
+  }
+}
+
+bool WorkStealingPool::popLocal(size_t iWorker, std::function<void()>& job) {
+  Worker& w = *workers[iWorker];
+  std::lock_guard<std::mutex> lock(w.mutex);
+  if (w.jobs.empty()) return false;
+  job = std::move(w.jobs.front());
+  w.jobs.pop_front();
+  return true;
+}
+
+bool WorkStealingPool::steal(size_t iThief, std::function<void()>& job) {
+  for (size_t offset = 1; offset < workers.size(); offset++) {
+    Worker& victim = *workers[(iThief + offset) % workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.jobs.empty()) continue;
+    job = std::move(victim.jobs.back());
+    victim.jobs.pop_back();
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::workerLoop(size_t iWorker) {
+  // Jobs never add more jobs, so once every deque is empty there is nothing left to do
+  std::function<void()> job;
+  while (popLocal(iWorker, job) || steal(iWorker, job)) {
+    try {
+      job();
+    } catch (const std::exception& e) {
+      std::cerr << "Error: uncaught exception in worker " << iWorker << ": " << e.what() << std::endl;
+    } catch (...) {
+      std::cerr << "Error: uncaught exception in worker " << iWorker << std::endl;
+    }
+    job = nullptr;
+  }
+}
+
+void WorkStealingPool::run() {
+  if (workers.size() == 1) {
+    workerLoop(0);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t iW = 0; iW < workers.size(); iW++) {
+    threads.emplace_back(&WorkStealingPool::workerLoop, this, iW);
+  }
+  for (std::thread& t : threads) t.join();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A fixed set of worker threads, each with its own deque of jobs. A worker takes jobs from the front of its own deque,
+// and once that is empty it steals from the back of the other workers' deques. All jobs must be added before calling
+// run(); jobs may not add further jobs.
+class WorkStealingPool {
+public:
+  WorkStealingPool(size_t nWorkers);
+
+  size_t nWorkers() const;
+
+  // Add a job to the back of a worker's deque
+  void push(size_t iWorker, std::function<void()> job);
+
+  // Deal jobs round-robin over the workers in the order given. If the jobs are sorted from most to least expensive,
+  // each worker starts with the most expensive jobs and thieves take the cheapest remaining ones.
+  void pushRoundRobin(std::vector<std::function<void()>> jobs);
+
+  // Run all jobs and return once every one of them has finished. Exceptions escaping a job are reported and
+  // otherwise ignored.
+  void run();
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  bool popLocal(size_t iWorker, std::function<void()>& job);
+  bool steal(size_t iThief, std::function<void()>& job);
+  void workerLoop(size_t iWorker);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+};